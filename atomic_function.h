@@ -0,0 +1,68 @@
+#ifndef FUNCTION_ATOMIC_FUNCTION_H
+#define FUNCTION_ATOMIC_FUNCTION_H
+
+#include <atomic>
+#include <function.h>
+#include <epoch.h>
+
+template <typename T>
+class atomic_function;
+
+// A function slot that is read on every call and replaced rarely. Readers take no locks and write
+// only their own epoch slot; the replaced target is freed once no reader can still see it.
+template <typename ReturnType, typename... Args>
+class atomic_function<ReturnType(Args...)>
+{
+    typedef function<ReturnType(Args...)> function_type;
+    typedef details::epoch_reclaimer::read_guard read_guard;
+
+public:
+    atomic_function() noexcept : target(nullptr) {}
+    atomic_function(std::nullptr_t) noexcept : atomic_function() {}
+
+    atomic_function(function_type f)
+        : target(f ? new function_type(std::move(f)) : nullptr)
+    {}
+
+    ~atomic_function()
+    {
+        delete target.load(std::memory_order_relaxed);
+    }
+
+    atomic_function(atomic_function const&) = delete;
+    atomic_function& operator=(atomic_function const&) = delete;
+
+    void store(function_type f)
+    {
+        function_type* replacement = f ? new function_type(std::move(f)) : nullptr;
+        function_type* old = target.exchange(replacement, std::memory_order_seq_cst);
+        if (old)
+            details::epoch_reclaimer::retire(old);
+    }
+
+    function_type load() const
+    {
+        read_guard guard;
+        function_type const* current = target.load(std::memory_order_seq_cst);
+        return current ? *current : function_type();
+    }
+
+    ReturnType operator()(Args... args) const
+    {
+        read_guard guard;
+        function_type const* current = target.load(std::memory_order_seq_cst);
+        if (!current)
+            details::empty_call(false);
+        return (*current)(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return target.load(std::memory_order_acquire) != nullptr;
+    }
+
+private:
+    std::atomic<function_type*> target;
+};
+
+#endif //FUNCTION_ATOMIC_FUNCTION_H
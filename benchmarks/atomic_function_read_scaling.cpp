@@ -0,0 +1,94 @@
+#include <atomic_function.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr auto RUN_TIME = std::chrono::milliseconds(300);
+    constexpr auto RELOAD_PERIOD = std::chrono::milliseconds(1);
+
+    struct locked_function
+    {
+        mutable std::shared_mutex mutex;
+        function<int(int)> f;
+
+        int operator()(int x) const
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return f(std::move(x));
+        }
+
+        void store(function<int(int)> g)
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            f = std::move(g);
+        }
+    };
+
+    // returns reader invocations per second summed over all readers
+    template <typename Slot>
+    double measure(Slot& slot, unsigned readers)
+    {
+        std::atomic<bool> stop{false};
+        std::vector<unsigned long long> calls(readers * 8);
+        std::vector<std::thread> threads;
+
+        for (unsigned i = 0; i < readers; ++i)
+        {
+            threads.emplace_back([&slot, &stop, &calls, i]()
+            {
+                unsigned long long count = 0;
+                int sink = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    for (int j = 0; j < 256; ++j)
+                        sink += slot(j);
+                    count += 256;
+                }
+                calls[i * 8] = count + (sink == 42);
+            });
+        }
+
+        std::thread writer([&slot, &stop]()
+        {
+            for (int generation = 0; !stop.load(std::memory_order_relaxed); ++generation)
+            {
+                slot.store([generation](int x){ return x + generation; });
+                std::this_thread::sleep_for(RELOAD_PERIOD);
+            }
+        });
+
+        std::this_thread::sleep_for(RUN_TIME);
+        stop.store(true);
+        writer.join();
+        for (std::thread& thread : threads)
+            thread.join();
+
+        unsigned long long total = 0;
+        for (unsigned i = 0; i < readers; ++i)
+            total += calls[i * 8];
+        return total / std::chrono::duration<double>(RUN_TIME).count();
+    }
+}
+
+int main()
+{
+    unsigned const hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%8s %22s %22s\n", "readers", "atomic_function Mops/s", "shared_mutex Mops/s");
+    for (unsigned readers = 1; readers <= 2 * hardware; readers *= 2)
+    {
+        atomic_function<int(int)> atomic([](int x){ return x; });
+        locked_function locked;
+        locked.store([](int x){ return x; });
+
+        double const lockFree = measure(atomic, readers);
+        double const withLock = measure(locked, readers);
+        std::printf("%8u %22.1f %22.1f\n", readers, lockFree / 1e6, withLock / 1e6);
+    }
+}
@@ -0,0 +1,17 @@
+# cmake -DSIZE_COMMAND=size -DFUNCTION_BINARY=... -DBASELINE_BINARY=... -P code_size.cmake
+# prints the .text growth that function adds per 1000 stored callable types
+
+function(text_size binary result)
+    execute_process(COMMAND ${SIZE_COMMAND} -A ${binary} OUTPUT_VARIABLE sections RESULT_VARIABLE status)
+    if (NOT status EQUAL 0)
+        message(FATAL_ERROR "${SIZE_COMMAND} failed on ${binary}")
+    endif ()
+    string(REGEX MATCH "\n\\.text +([0-9]+)" match "${sections}")
+    set(${result} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+text_size(${FUNCTION_BINARY} with_function)
+text_size(${BASELINE_BINARY} baseline)
+math(EXPR growth "${with_function} - ${baseline}")
+message(".text with function: ${with_function} bytes, baseline: ${baseline} bytes, "
+        "function adds ${growth} bytes per 1000 callable types")
@@ -0,0 +1,67 @@
+#include <function.h>
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// Built twice: bench-code-size stores CODE_SIZE_TARGETS distinct callable types in function,
+// bench-code-size-baseline calls the same targets through plain function pointers. The .text
+// difference is what function costs per instantiation, see benchmarks/code_size.cmake.
+namespace
+{
+    constexpr size_t CODE_SIZE_TARGETS = 1000;
+
+    template <size_t Index>
+    struct target
+    {
+        int bias;
+
+        int operator()(int x) const
+        {
+            return x * static_cast<int>(2 * Index + 1) + bias;
+        }
+    };
+
+#ifdef CODE_SIZE_BASELINE
+    typedef int (*callable_type)(int);
+
+    template <size_t Index>
+    int call_target(int x)
+    {
+        return target<Index>{static_cast<int>(Index)}(x);
+    }
+
+    template <size_t... Indices>
+    std::vector<callable_type> make_callables(std::index_sequence<Indices...>)
+    {
+        return {&call_target<Indices>...};
+    }
+#else
+    typedef function<int(int)> callable_type;
+
+    template <size_t... Indices>
+    std::vector<callable_type> make_callables(std::index_sequence<Indices...>)
+    {
+        std::vector<callable_type> result;
+        result.reserve(sizeof...(Indices));
+        (result.emplace_back(target<Indices>{static_cast<int>(Indices)}), ...);
+        return result;
+    }
+#endif
+}
+
+int main(int argc, char**)
+{
+    std::vector<callable_type> callables = make_callables(std::make_index_sequence<CODE_SIZE_TARGETS>());
+#ifndef CODE_SIZE_BASELINE
+    // copies and swaps instantiate the rest of the operations
+    std::vector<callable_type> copies = callables;
+    for (size_t i = 0; i + 1 < copies.size(); ++i)
+        copies[i].swap(copies[i + 1]);
+    callables = std::move(copies);
+#endif
+    int sum = 0;
+    for (callable_type const& f : callables)
+        sum += f(argc);
+    std::printf("%d\n", sum);
+}
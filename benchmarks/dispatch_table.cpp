@@ -0,0 +1,98 @@
+#include <dispatch_table.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr size_t LOOKUPS = 4096;
+    constexpr size_t ROUNDS = 512;
+
+    template <size_t Index>
+    struct handler
+    {
+        int operator()(int x) const
+        {
+            return x * static_cast<int>(2 * Index + 1);
+        }
+    };
+
+    typedef function<int(int)> function_type;
+    typedef std::function<int(int)> std_function_type;
+
+    template <typename Wrapper, size_t... Indices>
+    std::vector<Wrapper> handlers(std::index_sequence<Indices...>)
+    {
+        return {handler<Indices>()...};
+    }
+
+    std::vector<function_type> const targets = handlers<function_type>(std::make_index_sequence<16>());
+    std::vector<std_function_type> const std_targets = handlers<std_function_type>(std::make_index_sequence<16>());
+
+    volatile int sink;
+
+    template <typename Lookup>
+    double measure(Lookup const& lookup)
+    {
+        int sum = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; ++round)
+            for (size_t i = 0; i < LOOKUPS; ++i)
+                sum += lookup(i);
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        sink = sum;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / double(LOOKUPS * ROUNDS);
+    }
+
+    // the same keys in an unordered_map of std::function and in a dispatch_table, looked up in random order
+    template <typename Key>
+    void report(char const* name, std::vector<Key> const& keys)
+    {
+        std::unordered_map<Key, std_function_type> map;
+        std::vector<std::pair<Key, function_type>> entries;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            map.emplace(keys[i], std_targets[i % std_targets.size()]);
+            entries.emplace_back(keys[i], targets[i % targets.size()]);
+        }
+        dispatch_table<Key, int(int)> table(entries.begin(), entries.end());
+
+        std::vector<Key> order(LOOKUPS);
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+        for (Key& key : order)
+            key = keys[pick(random)];
+
+        double const mapTime = measure([&](size_t i) { return map.find(order[i])->second(static_cast<int>(i)); });
+        double const tableTime = measure([&](size_t i) { return table(order[i], static_cast<int>(i)); });
+        std::printf("%-8s %6zu %8s %14.2f %14.2f\n", name, keys.size(), table.dense() ? "dense" : "hashed",
+                    mapTime, tableTime);
+    }
+}
+
+int main()
+{
+    std::printf("ns per lookup and call\n%-8s %6s %8s %14s %14s\n", "keys", "count", "table",
+                "unordered_map", "dispatch_table");
+    for (size_t count : {8, 64, 512})
+    {
+        std::vector<int> dense(count);
+        std::vector<int> sparse(count);
+        std::vector<std::string> names(count);
+        std::mt19937 random(7);
+        for (size_t i = 0; i < count; ++i)
+        {
+            dense[i] = static_cast<int>(i);
+            sparse[i] = static_cast<int>(random() * static_cast<unsigned>(2 * i + 1));
+            names[i] = "opcode_" + std::to_string(i * 7919);
+        }
+        report("dense", dense);
+        report("sparse", sparse);
+        report("string", names);
+    }
+}
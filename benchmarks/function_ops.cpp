@@ -0,0 +1,126 @@
+#include <function.h>
+
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr size_t FUNCTIONS = 4096;
+    constexpr size_t ROUNDS = 256;
+    constexpr size_t POLYMORPHIC_TYPES = 64;
+
+    template <size_t Index>
+    struct adder
+    {
+        int operator()(int x) const
+        {
+            return x + static_cast<int>(Index);
+        }
+    };
+
+    typedef function<int(int)> function_type;
+    typedef function_type (*factory)();
+
+    template <size_t... Indices>
+    std::vector<factory> factories(std::index_sequence<Indices...>)
+    {
+        return {[]() { return function_type(adder<Indices>()); }...};
+    }
+
+    // every slot holds the same target type, or one of POLYMORPHIC_TYPES types in random order
+    std::vector<function_type> make_functions(bool polymorphic)
+    {
+        std::vector<factory> const makers = factories(std::make_index_sequence<POLYMORPHIC_TYPES>());
+        std::vector<function_type> result;
+        result.reserve(FUNCTIONS);
+        for (size_t i = 0; i < FUNCTIONS; ++i)
+            result.push_back(makers[polymorphic ? i % POLYMORPHIC_TYPES : 0]());
+        std::shuffle(result.begin(), result.end(), std::mt19937(42));
+        return result;
+    }
+
+    volatile int sink;
+
+    struct operation
+    {
+        char const* name;
+        void (*run)(std::vector<function_type>& functions);
+    };
+
+    operation const operations[] = {
+            {"invoke", [](std::vector<function_type>& functions)
+            {
+                int sum = 0;
+                for (size_t i = 0; i < functions.size(); ++i)
+                    sum += functions[i](static_cast<int>(i));
+                sink = sum;
+            }},
+            {"copy", [](std::vector<function_type>& functions)
+            {
+                for (size_t i = 0; i < functions.size(); ++i)
+                {
+                    function_type copy(functions[i]);
+                    sink = static_cast<bool>(copy);
+                }
+            }},
+            {"move", [](std::vector<function_type>& functions)
+            {
+                for (size_t i = 0; i < functions.size(); ++i)
+                {
+                    function_type moved(std::move(functions[i]));
+                    functions[i] = std::move(moved);
+                }
+            }},
+            {"swap", [](std::vector<function_type>& functions)
+            {
+                for (size_t i = 0; i + 1 < functions.size(); ++i)
+                    functions[i].swap(functions[i + 1]);
+            }},
+    };
+
+    void report(char const* pattern, operation const& op, perf_counters& counters)
+    {
+        std::vector<function_type> functions = make_functions(pattern[0] == 'p');
+        op.run(functions);
+
+        auto const start = std::chrono::steady_clock::now();
+        counters.start();
+        for (size_t round = 0; round < ROUNDS; ++round)
+            op.run(functions);
+        perf_counters::sample const sample = counters.stop();
+        double const elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        double const ops = double(FUNCTIONS) * ROUNDS;
+        std::printf("%-12s %-7s %8.2f", pattern, op.name, elapsed / ops);
+        for (int e = 0; e < perf_counters::event_count; ++e)
+        {
+            if (sample.available[e])
+                std::printf(" %13.3f", sample.values[e] / ops);
+            else
+                std::printf(" %13s", "n/a");
+        }
+        std::printf("\n");
+    }
+}
+
+int main()
+{
+    perf_counters counters;
+    if (!counters.any_available())
+        std::printf("hardware counters unavailable (check perf_event_paranoid), reporting time only\n");
+
+    std::printf("%-12s %-7s %8s", "pattern", "op", "ns/op");
+    for (int e = 0; e < perf_counters::event_count; ++e)
+        std::printf(" %13s", perf_counters::name(static_cast<perf_counters::event>(e)));
+    std::printf("\n");
+
+    for (char const* pattern : {"monomorphic", "polymorphic"})
+        for (operation const& op : operations)
+            report(pattern, op, counters);
+}
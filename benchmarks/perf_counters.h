@@ -0,0 +1,139 @@
+#ifndef FUNCTION_BENCHMARKS_PERF_COUNTERS_H
+#define FUNCTION_BENCHMARKS_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// User-space hardware counters for the calling thread through perf_event_open. Every event is
+// opened on its own, so a counter the kernel or the container refuses (perf_event_paranoid,
+// seccomp, a virtualized PMU) just reports as unavailable and the rest keep working.
+class perf_counters
+{
+public:
+    enum event
+    {
+        instructions,
+        cycles,
+        branch_misses,
+        l1d_misses,
+        llc_misses,
+        itlb_misses,
+        event_count
+    };
+
+    static char const* name(event e) noexcept
+    {
+        static char const* const names[event_count] =
+                {"instructions", "cycles", "branch-misses", "L1d-misses", "LLC-misses", "iTLB-misses"};
+        return names[e];
+    }
+
+    struct sample
+    {
+        bool available[event_count] = {};
+        double values[event_count] = {};
+    };
+
+    perf_counters()
+    {
+#ifdef __linux__
+        static std::uint64_t const configs[event_count][2] = {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D)},
+                {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL)},
+                {PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_ITLB)},
+        };
+
+        for (int e = 0; e < event_count; ++e)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = static_cast<std::uint32_t>(configs[e][0]);
+            attr.config = configs[e][1];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            descriptors[e] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~perf_counters()
+    {
+#ifdef __linux__
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                close(descriptor);
+#endif
+    }
+
+    perf_counters(perf_counters const&) = delete;
+    perf_counters& operator=(perf_counters const&) = delete;
+
+    bool any_available() const noexcept
+    {
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                return true;
+        return false;
+    }
+
+    void start() noexcept
+    {
+#ifdef __linux__
+        for (int descriptor : descriptors)
+        {
+            if (descriptor >= 0)
+            {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // counts since start(), scaled up when the kernel had to multiplex a counter
+    sample stop() noexcept
+    {
+        sample result;
+#ifdef __linux__
+        for (int descriptor : descriptors)
+            if (descriptor >= 0)
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+        for (int e = 0; e < event_count; ++e)
+        {
+            std::uint64_t data[3];
+            if (descriptors[e] < 0 || read(descriptors[e], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+                continue;
+            result.available[e] = true;
+            result.values[e] = double(data[0]) * double(data[1]) / double(data[2]);
+        }
+#endif
+        return result;
+    }
+
+private:
+#ifdef __linux__
+    static constexpr std::uint64_t cache(std::uint64_t id) noexcept
+    {
+        return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+    int descriptors[event_count] = {-1, -1, -1, -1, -1, -1};
+};
+
+#endif //FUNCTION_BENCHMARKS_PERF_COUNTERS_H
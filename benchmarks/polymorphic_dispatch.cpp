@@ -0,0 +1,188 @@
+#include <function.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr size_t MAX_TYPES = 256;
+    constexpr size_t CALLS = 4096;
+    constexpr size_t ROUNDS = 512;
+
+    // MAX_TYPES distinct targets, each with its own code so that every type is its own branch target
+    template <size_t Index>
+    struct target
+    {
+        int bias;
+
+        int operator()(int x) const
+        {
+            return x * static_cast<int>(2 * Index + 1) + bias;
+        }
+    };
+
+    // function pointer stored next to the object, no vtable load on the way to the call
+    class invoker_function
+    {
+    public:
+        invoker_function() = default;
+
+        template <typename CallableType>
+        invoker_function(CallableType f)
+            : invoker([](void const* storage, int x) { return (*static_cast<CallableType const*>(storage))(x); })
+        {
+            static_assert(sizeof(CallableType) <= sizeof(storage), "target doesn't fit");
+            new (&storage) CallableType(f);
+        }
+
+        int operator()(int x) const
+        {
+            return invoker(&storage, x);
+        }
+
+    private:
+        int (*invoker)(void const*, int) = nullptr;
+        std::aligned_storage<16, 8>::type storage;
+    };
+
+    // a closed set of targets identified by their index, dispatched with one switch
+    struct switch_function
+    {
+        unsigned kind;
+        int bias;
+
+        int operator()(int x) const
+        {
+            switch (kind)
+            {
+#define DISPATCH_CASE(i) case i: return target<i>{bias}(x);
+#define DISPATCH_CASE4(i) DISPATCH_CASE(i) DISPATCH_CASE(i + 1) DISPATCH_CASE(i + 2) DISPATCH_CASE(i + 3)
+#define DISPATCH_CASE16(i) DISPATCH_CASE4(i) DISPATCH_CASE4(i + 4) DISPATCH_CASE4(i + 8) DISPATCH_CASE4(i + 12)
+#define DISPATCH_CASE64(i) DISPATCH_CASE16(i) DISPATCH_CASE16(i + 16) DISPATCH_CASE16(i + 32) DISPATCH_CASE16(i + 48)
+            DISPATCH_CASE64(0)
+            DISPATCH_CASE64(64)
+            DISPATCH_CASE64(128)
+            DISPATCH_CASE64(192)
+#undef DISPATCH_CASE64
+#undef DISPATCH_CASE16
+#undef DISPATCH_CASE4
+#undef DISPATCH_CASE
+            default:
+                return x;
+            }
+        }
+    };
+
+    template <typename Wrapper>
+    struct wrapper_factory
+    {
+        typedef Wrapper (*type)(int bias);
+
+        template <size_t... Indices>
+        static std::vector<type> all(std::index_sequence<Indices...>)
+        {
+            return {[](int bias) { return Wrapper(target<Indices>{bias}); }...};
+        }
+    };
+
+    enum class order
+    {
+        sequential,
+        random,
+        skewed
+    };
+
+    char const* const order_names[] = {"sequential", "random", "skewed"};
+
+    // which target type each call site slot holds
+    std::vector<unsigned> make_kinds(size_t types, order pattern)
+    {
+        std::vector<unsigned> kinds(CALLS);
+        std::mt19937 random(42);
+        if (pattern == order::sequential)
+        {
+            for (size_t i = 0; i < CALLS; ++i)
+                kinds[i] = static_cast<unsigned>(i % types);
+        }
+        else if (pattern == order::random)
+        {
+            std::uniform_int_distribution<unsigned> uniform(0, static_cast<unsigned>(types - 1));
+            for (unsigned& kind : kinds)
+                kind = uniform(random);
+        }
+        else
+        {
+            // zipf-like: the k-th most common type is called proportionally to 1 / (k + 1)
+            std::vector<double> weights(types);
+            for (size_t k = 0; k < types; ++k)
+                weights[k] = 1.0 / double(k + 1);
+            std::discrete_distribution<unsigned> zipf(weights.begin(), weights.end());
+            for (unsigned& kind : kinds)
+                kind = zipf(random);
+        }
+        return kinds;
+    }
+
+    volatile int sink;
+
+    template <typename Wrapper>
+    double measure(std::vector<Wrapper> const& calls)
+    {
+        int sum = 0;
+        for (size_t i = 0; i < calls.size(); ++i)
+            sum += calls[i](static_cast<int>(i));
+
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; ++round)
+            for (size_t i = 0; i < calls.size(); ++i)
+                sum += calls[i](static_cast<int>(i));
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        sink = sum;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / double(calls.size() * ROUNDS);
+    }
+
+    template <typename Wrapper>
+    double measure(std::vector<unsigned> const& kinds)
+    {
+        static std::vector<typename wrapper_factory<Wrapper>::type> const factories =
+                wrapper_factory<Wrapper>::all(std::make_index_sequence<MAX_TYPES>());
+        std::vector<Wrapper> calls;
+        calls.reserve(kinds.size());
+        for (size_t i = 0; i < kinds.size(); ++i)
+            calls.push_back(factories[kinds[i]](static_cast<int>(i)));
+        return measure(calls);
+    }
+
+    double measure_switch(std::vector<unsigned> const& kinds)
+    {
+        std::vector<switch_function> calls;
+        calls.reserve(kinds.size());
+        for (size_t i = 0; i < kinds.size(); ++i)
+            calls.push_back({kinds[i], static_cast<int>(i)});
+        return measure(calls);
+    }
+}
+
+int main()
+{
+    std::printf("ns per call over %zu call slots\n", CALLS);
+    for (order pattern : {order::sequential, order::random, order::skewed})
+    {
+        std::printf("\n%-10s %6s %10s %10s %14s %10s\n", order_names[static_cast<int>(pattern)], "types",
+                    "function", "invoker", "std::function", "switch");
+        for (size_t types = 1; types <= MAX_TYPES; types *= 2)
+        {
+            std::vector<unsigned> const kinds = make_kinds(types, pattern);
+            std::printf("%-10s %6zu %10.2f %10.2f %14.2f %10.2f\n", "", types,
+                        measure<function<int(int)>>(kinds), measure<invoker_function>(kinds),
+                        measure<std::function<int(int)>>(kinds), measure_switch(kinds));
+        }
+    }
+}
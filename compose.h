@@ -0,0 +1,102 @@
+#ifndef FUNCTION_COMPOSE_H
+#define FUNCTION_COMPOSE_H
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace details
+{
+    // All stages of a chain in one flat tuple; calling it runs them in order with no erasure in
+    // between, so wrapping a pipeline in a function costs a single dispatch.
+    template <typename... Stages>
+    class pipeline
+    {
+        static_assert(sizeof...(Stages) > 0, "pipeline needs at least one stage");
+
+        typedef std::tuple<Stages...> stages_type;
+
+        stages_type stages_;
+
+        template <size_t Index, typename Self, typename... CallArgs>
+        static decltype(auto) run(Self& self, CallArgs&&... args)
+        {
+            if constexpr (Index + 1 == sizeof...(Stages))
+                return std::invoke(std::get<Index>(self.stages_), std::forward<CallArgs>(args)...);
+            else
+                return run<Index + 1>(self, std::invoke(std::get<Index>(self.stages_), std::forward<CallArgs>(args)...));
+        }
+
+    public:
+        explicit pipeline(stages_type stages) : stages_(std::move(stages)) {}
+
+        template <typename... CallArgs>
+        decltype(auto) operator()(CallArgs&&... args)
+        {
+            return run<0>(*this, std::forward<CallArgs>(args)...);
+        }
+
+        template <typename... CallArgs>
+        decltype(auto) operator()(CallArgs&&... args) const
+        {
+            return run<0>(*this, std::forward<CallArgs>(args)...);
+        }
+
+        stages_type const& stages() const& noexcept
+        {
+            return stages_;
+        }
+
+        stages_type&& stages() && noexcept
+        {
+            return std::move(stages_);
+        }
+    };
+
+    template <typename T>
+    struct is_pipeline : std::false_type
+    {};
+
+    template <typename... Stages>
+    struct is_pipeline<pipeline<Stages...>> : std::true_type
+    {};
+
+    // a nested pipeline contributes its own stages, anything else is one stage
+    template <typename Stage>
+    auto as_stages(Stage&& stage)
+    {
+        if constexpr (is_pipeline<std::decay_t<Stage>>::value)
+            return std::forward<Stage>(stage).stages();
+        else
+            return std::tuple<std::decay_t<Stage>>(std::forward<Stage>(stage));
+    }
+
+    template <typename... Stages>
+    pipeline<Stages...> make_pipeline(std::tuple<Stages...> stages)
+    {
+        return pipeline<Stages...>(std::move(stages));
+    }
+}
+
+// pipe(f, g, h)(x) == h(g(f(x)))
+template <typename... Stages>
+auto pipe(Stages&&... stages)
+{
+    return details::make_pipeline(std::tuple_cat(details::as_stages(std::forward<Stages>(stages))...));
+}
+
+// compose(f, g, h)(x) == f(g(h(x)))
+template <typename Stage>
+auto compose(Stage&& stage)
+{
+    return pipe(std::forward<Stage>(stage));
+}
+
+template <typename Stage, typename... Stages>
+auto compose(Stage&& stage, Stages&&... stages)
+{
+    return pipe(compose(std::forward<Stages>(stages)...), std::forward<Stage>(stage));
+}
+
+#endif //FUNCTION_COMPOSE_H
@@ -0,0 +1,307 @@
+#ifndef FUNCTION_DISPATCH_TABLE_H
+#define FUNCTION_DISPATCH_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <function.h>
+
+namespace details
+{
+    inline std::uint64_t splitmix64(std::uint64_t x) noexcept
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    inline std::uint64_t fnv1a(std::string_view bytes, std::uint64_t seed) noexcept
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+        for (char c : bytes)
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        return hash;
+    }
+
+    // Integers and enums are looked up as themselves and may get a dense table; anything else must
+    // convert to std::string_view and is kept as a std::string.
+    template <typename Key, bool = std::is_integral<Key>::value || std::is_enum<Key>::value>
+    struct dispatch_key
+    {
+        typedef Key lookup_type;
+        typedef Key stored_type;
+        static constexpr bool integral = true;
+
+        static std::uint64_t value(Key key) noexcept
+        {
+            if constexpr (std::is_enum<Key>::value)
+                return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<Key>>(key));
+            else
+                return static_cast<std::uint64_t>(key);
+        }
+
+        static std::uint64_t hash(Key key, std::uint64_t seed) noexcept
+        {
+            return splitmix64(value(key) ^ seed);
+        }
+    };
+
+    template <typename Key>
+    struct dispatch_key<Key, false>
+    {
+        typedef std::string_view lookup_type;
+        typedef std::string stored_type;
+        static constexpr bool integral = false;
+
+        static std::uint64_t hash(std::string_view key, std::uint64_t seed) noexcept
+        {
+            return splitmix64(fnv1a(key, seed));
+        }
+    };
+}
+
+// An immutable map from a fixed set of keys to functions, built once at startup. Integer and enum
+// keys that span at most twice as many values as there are entries index a dense array directly;
+// other key sets get a perfect hash (hash and displace: a key's bucket picks the displacement that
+// puts it in its own slot), so a lookup is one hash, one key compare and one indirect call. Keys that
+// aren't in the table call the fallback, which throws bad_function_call unless one was given.
+template <typename Key, typename Signature>
+class dispatch_table
+{
+    typedef details::dispatch_key<Key> key_traits;
+    typedef typename key_traits::lookup_type lookup_type;
+    typedef typename key_traits::stored_type stored_type;
+
+public:
+    typedef function<Signature> function_type;
+    typedef std::pair<Key, function_type> value_type;
+
+    dispatch_table(std::initializer_list<value_type> entries, function_type fallback = nullptr)
+        : dispatch_table(entries.begin(), entries.end(), std::move(fallback))
+    {}
+
+    template <typename Iterator>
+    dispatch_table(Iterator first, Iterator last, function_type fallback = nullptr)
+    {
+        std::vector<std::pair<stored_type, function_type>> entries;
+        for (; first != last; ++first)
+            entries.emplace_back(stored_type(first->first), first->second);
+        entryCount = entries.size();
+
+        if constexpr (key_traits::integral)
+            if (buildDense(entries, fallback))
+                return;
+        buildHashed(entries, fallback);
+    }
+
+    template <typename... CallArgs>
+    decltype(auto) operator()(lookup_type key, CallArgs&&... args) const
+    {
+        return functions[position(key)](std::forward<CallArgs>(args)...);
+    }
+
+    // nullptr for keys without an entry
+    function_type const* find(lookup_type key) const noexcept
+    {
+        size_t const index = position(key);
+        return present[index] ? &functions[index] : nullptr;
+    }
+
+    bool contains(lookup_type key) const noexcept
+    {
+        return find(key) != nullptr;
+    }
+
+    size_t size() const noexcept
+    {
+        return entryCount;
+    }
+
+    bool dense() const noexcept
+    {
+        return denseKeys;
+    }
+
+private:
+    static constexpr size_t DENSE_MIN_SPAN = 16;
+    static constexpr std::uint32_t MAX_DISPLACEMENT = 1u << 16;
+
+    size_t position(lookup_type key) const noexcept
+    {
+        size_t const fallbackIndex = functions.size() - 1;
+        if constexpr (key_traits::integral)
+        {
+            if (denseKeys)
+            {
+                std::uint64_t const index = key_traits::value(key) - base;
+                return index < fallbackIndex ? static_cast<size_t>(index) : fallbackIndex;
+            }
+        }
+        std::uint64_t const hash = key_traits::hash(key, seed);
+        size_t const index = slot(hash, displacements[hash & bucketMask]);
+        return keys[index] == key ? index : fallbackIndex;
+    }
+
+    size_t slot(std::uint64_t hash, std::uint32_t displacement) const noexcept
+    {
+        return static_cast<size_t>(details::splitmix64(hash + displacement) >> 32) & hashMask;
+    }
+
+    // the last slot always holds the fallback, every hole a copy of it
+    void fill(size_t slots, function_type const& fallback)
+    {
+        functions.assign(slots + 1, fallback);
+        present.assign(slots + 1, false);
+    }
+
+    bool buildDense(std::vector<std::pair<stored_type, function_type>>& entries, function_type const& fallback)
+    {
+        if (entries.empty())
+        {
+            fill(0, fallback);
+            denseKeys = true;
+            return true;
+        }
+
+        auto const bounds = std::minmax_element(entries.begin(), entries.end(), [](auto const& a, auto const& b)
+        {
+            return a.first < b.first;
+        });
+        std::uint64_t const span = key_traits::value(bounds.second->first) - key_traits::value(bounds.first->first);
+        if (span >= std::max<std::uint64_t>(2 * entries.size(), DENSE_MIN_SPAN))
+            return false;
+
+        base = key_traits::value(bounds.first->first);
+        fill(static_cast<size_t>(span) + 1, fallback);
+        for (auto& entry : entries)
+        {
+            size_t const index = static_cast<size_t>(key_traits::value(entry.first) - base);
+            if (present[index])
+                details::throw_exception<std::invalid_argument>("duplicate dispatch_table key");
+            functions[index] = std::move(entry.second);
+            present[index] = true;
+        }
+        denseKeys = true;
+        return true;
+    }
+
+    void buildHashed(std::vector<std::pair<stored_type, function_type>>& entries, function_type const& fallback)
+    {
+        size_t slots = 1;
+        while (slots < entries.size() + entries.size() / 4 + 1)
+            slots *= 2;
+
+        // a new seed when two keys hash alike, a bigger table when some bucket can't be placed
+        for (std::uint64_t attempt = 0;; ++attempt)
+        {
+            seed = details::splitmix64(attempt);
+            if (tryBuild(entries, slots, fallback))
+                return;
+            if (attempt % 4 == 3)
+                slots *= 2;
+        }
+    }
+
+    bool tryBuild(std::vector<std::pair<stored_type, function_type>>& entries, size_t slots, function_type const& fallback)
+    {
+        size_t const buckets = std::max<size_t>(1, slots / 4);
+        hashMask = slots - 1;
+        bucketMask = buckets - 1;
+
+        std::vector<std::uint64_t> hashes(entries.size());
+        std::vector<std::vector<size_t>> members(buckets);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            hashes[i] = key_traits::hash(entries[i].first, seed);
+            members[hashes[i] & bucketMask].push_back(i);
+        }
+
+        std::vector<size_t> order(buckets);
+        for (size_t b = 0; b < buckets; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return members[a].size() > members[b].size();
+        });
+
+        // largest buckets first, while the table still has room for them
+        displacements.assign(buckets, 0);
+        std::vector<size_t> owner(slots, entries.size());
+        std::vector<size_t> placed;
+        for (size_t bucket : order)
+        {
+            std::vector<size_t> const& bucketMembers = members[bucket];
+            if (bucketMembers.empty())
+                break;
+
+            bool found = false;
+            for (std::uint32_t displacement = 0; !found && displacement < MAX_DISPLACEMENT; ++displacement)
+            {
+                placed.clear();
+                found = true;
+                for (size_t member : bucketMembers)
+                {
+                    size_t const index = slot(hashes[member], displacement);
+                    if (owner[index] != entries.size() ||
+                        std::find(placed.begin(), placed.end(), index) != placed.end())
+                    {
+                        found = false;
+                        break;
+                    }
+                    placed.push_back(index);
+                }
+                if (found)
+                    displacements[bucket] = displacement;
+            }
+            if (!found)
+            {
+                checkDuplicates(entries, bucketMembers);
+                return false;
+            }
+            for (size_t i = 0; i < bucketMembers.size(); ++i)
+                owner[placed[i]] = bucketMembers[i];
+        }
+
+        fill(slots, fallback);
+        keys.assign(slots, stored_type());
+        for (size_t index = 0; index < slots; ++index)
+        {
+            if (owner[index] == entries.size())
+                continue;
+            keys[index] = std::move(entries[owner[index]].first);
+            functions[index] = std::move(entries[owner[index]].second);
+            present[index] = true;
+        }
+        return true;
+    }
+
+    // equal keys always collide, no seed or table size will separate them
+    static void checkDuplicates(std::vector<std::pair<stored_type, function_type>> const& entries,
+                                std::vector<size_t> const& bucketMembers)
+    {
+        for (size_t i = 0; i < bucketMembers.size(); ++i)
+            for (size_t j = i + 1; j < bucketMembers.size(); ++j)
+                if (entries[bucketMembers[i]].first == entries[bucketMembers[j]].first)
+                    details::throw_exception<std::invalid_argument>("duplicate dispatch_table key");
+    }
+
+    std::vector<function_type> functions;
+    std::vector<bool> present;
+    std::vector<stored_type> keys;
+    std::vector<std::uint32_t> displacements;
+    std::uint64_t seed = 0;
+    std::uint64_t base = 0;
+    size_t hashMask = 0;
+    size_t bucketMask = 0;
+    size_t entryCount = 0;
+    bool denseKeys = false;
+};
+
+#endif //FUNCTION_DISPATCH_TABLE_H
@@ -0,0 +1,146 @@
+#ifndef FUNCTION_EPOCH_H
+#define FUNCTION_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <function.h>
+
+namespace details
+{
+    constexpr size_t EPOCH_MAX_READERS = 256;
+    constexpr size_t EPOCH_CACHE_LINE = 64;
+
+    struct alignas(EPOCH_CACHE_LINE) epoch_reader_slot
+    {
+        std::atomic<std::uint64_t> active{0};
+        std::atomic<bool> used{false};
+    };
+
+    struct epoch_reader_registration
+    {
+        epoch_reader_slot* slot = nullptr;
+        unsigned depth = 0;
+
+        ~epoch_reader_registration()
+        {
+            if (slot)
+                slot->used.store(false, std::memory_order_release);
+        }
+    };
+
+    struct epoch_retired_object
+    {
+        void* object;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    struct epoch_retired_list
+    {
+        std::mutex mutex;
+        std::vector<epoch_retired_object> objects;
+
+        ~epoch_retired_list()
+        {
+            for (epoch_retired_object const& retired : objects)
+                retired.deleter(retired.object);
+        }
+    };
+
+    // Epoch based reclamation for the lock-free readers in this library. A reader publishes the
+    // epoch it started in to its own cache line; a retired object is freed once every active reader
+    // has started after the object was retired.
+    class epoch_reclaimer
+    {
+    public:
+        class read_guard
+        {
+        public:
+            read_guard()
+            {
+                epoch_reader_registration& reader = registration;
+                if (reader.depth++ == 0)
+                {
+                    if (!reader.slot)
+                        reader.slot = acquireSlot();
+                    reader.slot->active.store(globalEpoch.load(), std::memory_order_seq_cst);
+                }
+            }
+
+            ~read_guard()
+            {
+                epoch_reader_registration& reader = registration;
+                if (--reader.depth == 0)
+                    reader.slot->active.store(0, std::memory_order_release);
+            }
+
+            read_guard(read_guard const&) = delete;
+            read_guard& operator=(read_guard const&) = delete;
+        };
+
+        template <typename T>
+        static void retire(T* object)
+        {
+            retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+        }
+
+        static void retire(void* object, void (*deleter)(void*))
+        {
+            std::lock_guard<std::mutex> lock(retired.mutex);
+            retired.objects.push_back({object, deleter, globalEpoch.fetch_add(1) + 1});
+            reclaimLocked();
+        }
+
+        // frees whatever is no longer visible to readers, writers call it implicitly on retire
+        static void reclaim()
+        {
+            std::lock_guard<std::mutex> lock(retired.mutex);
+            reclaimLocked();
+        }
+
+    private:
+        static epoch_reader_slot* acquireSlot()
+        {
+            for (epoch_reader_slot& slot : slots)
+            {
+                bool expected = false;
+                if (!slot.used.load(std::memory_order_relaxed) &&
+                    slot.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    return &slot;
+            }
+            throw_exception<std::length_error>("too many concurrent reader threads");
+        }
+
+        static void reclaimLocked()
+        {
+            std::uint64_t oldest = UINT64_MAX;
+            for (epoch_reader_slot const& slot : slots)
+            {
+                std::uint64_t const active = slot.active.load(std::memory_order_seq_cst);
+                if (active != 0 && active < oldest)
+                    oldest = active;
+            }
+
+            auto& objects = retired.objects;
+            size_t kept = 0;
+            for (size_t i = 0; i < objects.size(); ++i)
+            {
+                if (objects[i].epoch <= oldest)
+                    objects[i].deleter(objects[i].object);
+                else
+                    objects[kept++] = objects[i];
+            }
+            objects.resize(kept);
+        }
+
+        inline static std::atomic<std::uint64_t> globalEpoch{1};
+        inline static epoch_reader_slot slots[EPOCH_MAX_READERS];
+        inline static thread_local epoch_reader_registration registration;
+        inline static epoch_retired_list retired;
+    };
+}
+
+#endif //FUNCTION_EPOCH_H
@@ -0,0 +1,5 @@
+#include <function.h>
+
+#define FUNCTION_INSTANTIATION(...) template __VA_ARGS__;
+FUNCTION_COMMON_INSTANTIATIONS(FUNCTION_INSTANTIATION)
+#undef FUNCTION_INSTANTIATION
@@ -0,0 +1,19 @@
+// C++20 named module for function.h: import function;
+// The standard headers go to the global module fragment, so including function.h in the purview
+// only declares function's own entities, and all of them are exported.
+module;
+
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+export module function;
+
+export
+{
+#include "function.h"
+}
@@ -1,188 +1,726 @@
 #ifndef FUNCTION_FUNCTION_H
 #define FUNCTION_FUNCTION_H
 
-#include <memory>
-#include <functional>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
-constexpr size_t SMALL_SIZE = 32;
-constexpr size_t SMALL_ALIGN = 32;
+// C++20 lets captureless lambdas and function pointers be stored and called in constant expressions;
+// anything that needs the buffer or the heap stays runtime-only.
+#if __cplusplus >= 202002L && defined(__cpp_lib_is_constant_evaluated)
+#define FUNCTION_HAS_CONSTEXPR20
+#define FUNCTION_CONSTEXPR20 constexpr
+#else
+#define FUNCTION_CONSTEXPR20
+#endif
 
-namespace
+#ifdef FUNCTION_INSTRUMENTATION
+#include <function_instrumentation.h>
+#ifdef FUNCTION_HAS_CONSTEXPR20
+#define FUNCTION_RECORD(StorageType, event) (std::is_constant_evaluated() ? static_cast<void>(0) : \
+    ::details::record_function_event<StorageType>(function_event::event))
+#else
+#define FUNCTION_RECORD(StorageType, event) ::details::record_function_event<StorageType>(function_event::event)
+#endif
+#else
+#define FUNCTION_RECORD(StorageType, event) static_cast<void>(0)
+#endif
+
+// Built with -fno-exceptions, everything these headers would throw aborts instead.
+#if !defined(FUNCTION_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define FUNCTION_NO_EXCEPTIONS
+#endif
+
+inline constexpr size_t SMALL_SIZE = 32;
+inline constexpr size_t SMALL_ALIGN = 32;
+
+// Thrown by calls to an empty function; std::bad_function_call would cost every includer <functional>.
+class bad_function_call : public std::exception
 {
-    template <typename T>
-    struct is_small
+public:
+    char const* what() const noexcept override
     {
-        static constexpr bool value =
-                sizeof(T) <= SMALL_SIZE && alignof(T) <= SMALL_ALIGN && std::is_nothrow_move_constructible<T>::value;
-    };
-}
+        return "bad function call";
+    }
+};
 
-template <typename T>
-class function;
+// Called before an empty function reports the call; it may throw, log or abort itself, and if it
+// returns, bad_function_call is thrown (std::abort without exceptions, std::terminate for noexcept
+// signatures). Meant to be set once at startup.
+typedef void (*empty_call_handler)();
 
-template <typename ReturnType, typename... Args>
-class function<ReturnType(Args...)>
+namespace details
 {
-    typedef std::aligned_storage<SMALL_SIZE, SMALL_ALIGN>::type SmallObjectType;
+    inline empty_call_handler current_empty_call_handler = nullptr;
 
-public:
-    function() noexcept : small(false), bigStorage() {}
-    function(std::nullptr_t) noexcept : function() {}
+    template <typename Exception, typename... ExceptionArgs>
+    [[noreturn]] void throw_exception(ExceptionArgs&&... args)
+    {
+#ifdef FUNCTION_NO_EXCEPTIONS
+        ((void)args, ...);
+        std::abort();
+#else
+        throw Exception(std::forward<ExceptionArgs>(args)...);
+#endif
+    }
 
-    function(function const& other): small(other.small)
+    [[noreturn]] inline void empty_call(bool noexceptSignature)
     {
-        if (small)
-            (reinterpret_cast<function_storage_base const*>(&other.smallStorage))->cloneTo(&smallStorage);
-        else
-            bigStorage = other.bigStorage->clone();
+        if (current_empty_call_handler)
+            current_empty_call_handler();
+        if (noexceptSignature)
+            std::terminate();
+        throw_exception<bad_function_call>();
     }
+}
 
-    function(function&& other) noexcept: small(other.small)
+// returns the previous handler
+inline empty_call_handler set_empty_call_handler(empty_call_handler handler) noexcept
+{
+    empty_call_handler previous = details::current_empty_call_handler;
+    details::current_empty_call_handler = handler;
+    return previous;
+}
+
+namespace details
+{
+    // the object a member pointer applies to: the argument itself or what it points to
+    template <typename ClassType, typename Object>
+    constexpr decltype(auto) member_object(Object&& object) noexcept
     {
-        if (small)
-        {
-            (reinterpret_cast<function_storage_base*>(&other.smallStorage))->moveTo(&smallStorage);
-        }
+        if constexpr (std::is_base_of<ClassType, std::decay_t<Object>>::value)
+            return std::forward<Object>(object);
         else
-        {
-            bigStorage = std::move(other.bigStorage);
-        }
+            return *std::forward<Object>(object);
     }
 
-    template <typename CallableType>
-    function(CallableType f)
+    template <typename MemberType, typename ClassType, typename Object, typename... CallArgs>
+    constexpr decltype(auto) invoke_member(MemberType ClassType::* member, Object&& object, CallArgs&&... args)
     {
-        if constexpr (is_small<CallableType>::value)
-        {
-            small = true;
-            new (&smallStorage) function_storage<CallableType>(std::move(f));
-        }
+        if constexpr (std::is_function<MemberType>::value)
+            return (member_object<ClassType>(std::forward<Object>(object)).*member)(std::forward<CallArgs>(args)...);
         else
-        {
-            small = false;
-            bigStorage = std::make_unique<function_storage<CallableType>>(std::move(f));
-        }
+            return (member_object<ClassType>(std::forward<Object>(object)).*member);
     }
 
-    ~function()
+    // std::invoke without <functional>, except that reference_wrapper objects aren't unwrapped for
+    // member pointers
+    template <typename CallableType, typename... CallArgs>
+    constexpr decltype(auto) invoke(CallableType&& f, CallArgs&&... args)
+            noexcept(std::is_nothrow_invocable<CallableType, CallArgs...>::value)
     {
-        if (small)
-            reinterpret_cast<function_storage_base*>(&smallStorage)->~function_storage_base();
+        if constexpr (std::is_member_pointer<std::decay_t<CallableType>>::value)
+            return invoke_member(f, std::forward<CallArgs>(args)...);
         else
-            bigStorage.reset();
+            return std::forward<CallableType>(f)(std::forward<CallArgs>(args)...);
     }
 
-    void swap(function& other) noexcept
+    template <typename T>
+    struct is_small
+    {
+        static constexpr bool value =
+                sizeof(T) <= SMALL_SIZE && alignof(T) <= SMALL_ALIGN && std::is_nothrow_move_constructible<T>::value;
+    };
+
+    enum class call_qualifier
+    {
+        none,
+        const_,
+        lvalue,
+        const_lvalue,
+        rvalue,
+        const_rvalue
+    };
+
+    template <typename CallableType, call_qualifier Qualifier>
+    struct qualified_callable
     {
-        if (small && other.small)
+        typedef CallableType& type;
+    };
+
+    template <typename CallableType>
+    struct qualified_callable<CallableType, call_qualifier::const_>
+    {
+        typedef CallableType const& type;
+    };
+
+    template <typename CallableType>
+    struct qualified_callable<CallableType, call_qualifier::const_lvalue>
+    {
+        typedef CallableType const& type;
+    };
+
+    template <typename CallableType>
+    struct qualified_callable<CallableType, call_qualifier::rvalue>
+    {
+        typedef CallableType&& type;
+    };
+
+    template <typename CallableType>
+    struct qualified_callable<CallableType, call_qualifier::const_rvalue>
+    {
+        typedef CallableType const&& type;
+    };
+
+    enum class storage_operation
+    {
+        clone,
+        move,
+        destroy,
+#ifdef FUNCTION_INSTRUMENTATION
+        swapped
+#endif
+    };
+
+    typedef void (*storage_manager)(storage_operation operation, void* source, void* destination);
+
+    // The invoker and the manager of one callable type for one signature. A small target lives in the
+    // buffer itself, a big one on the heap with the buffer holding the pointer. All cold operations
+    // share the manager, so a callable type costs two functions instead of a vtable of five.
+    // A stateless target isn't stored at all, every call uses a fresh one.
+    template <typename CallableType, typename ReturnType, bool Noexcept, call_qualifier Qualifier, typename... Args>
+    struct function_storage
+    {
+        typedef typename qualified_callable<CallableType, Qualifier>::type qualified_type;
+
+        static constexpr bool stateless = std::is_empty<CallableType>::value &&
+                                          std::is_trivially_default_constructible<CallableType>::value &&
+                                          std::is_trivially_copyable<CallableType>::value;
+        static constexpr bool small = is_small<CallableType>::value;
+
+        static CallableType* object(void* storage) noexcept
         {
-            SmallObjectType tmp;
-            (reinterpret_cast<function_storage_base*>(&other.smallStorage))->moveTo(&tmp);
-            (reinterpret_cast<function_storage_base*>(&smallStorage))->moveTo(&other.smallStorage);
-            (reinterpret_cast<function_storage_base*>(&tmp))->moveTo(&smallStorage);
+            if constexpr (small)
+                return static_cast<CallableType*>(storage);
+            else
+                return *static_cast<CallableType**>(storage);
         }
-        else if (!small && !other.small)
+
+        template <typename... CtorArgs>
+        static FUNCTION_CONSTEXPR20 void create(void* storage, CtorArgs&&... args)
         {
-            std::swap(bigStorage, other.bigStorage);
+            if constexpr (stateless)
+            {
+                static_cast<void>(storage);
+                (static_cast<void>(args), ...);
+            }
+            else if constexpr (small)
+            {
+                new (storage) CallableType(std::forward<CtorArgs>(args)...);
+            }
+            else
+            {
+                *static_cast<CallableType**>(storage) = new CallableType(std::forward<CtorArgs>(args)...);
+                FUNCTION_RECORD(function_storage, heap_spill);
+            }
+            FUNCTION_RECORD(function_storage, construct);
         }
-        else if (small && !other.small)
+
+        static FUNCTION_CONSTEXPR20 ReturnType call(CallableType& f, Args&&... args) noexcept(Noexcept)
         {
-            auto tmp = std::move(other.bigStorage);
-            (reinterpret_cast<function_storage_base*>(&smallStorage))->moveTo(&other.smallStorage);
-            bigStorage = std::move(tmp);
+            FUNCTION_RECORD(function_storage, invoke);
+            if constexpr (std::is_void<ReturnType>::value)
+                details::invoke(static_cast<qualified_type>(f), std::forward<Args>(args)...);
+            else
+                return details::invoke(static_cast<qualified_type>(f), std::forward<Args>(args)...);
         }
-        else
+
+        static FUNCTION_CONSTEXPR20 ReturnType invoke(void* storage, Args&&... args) noexcept(Noexcept)
         {
-            SmallObjectType tmp;
-            (reinterpret_cast<function_storage_base*>(&other.smallStorage))->moveTo(&tmp);
-            std::swap(other.bigStorage, bigStorage);
-            (reinterpret_cast<function_storage_base*>(&tmp))->moveTo(&smallStorage);
+            if constexpr (stateless)
+            {
+                CallableType f{};
+                return call(f, std::forward<Args>(args)...);
+            }
+            else
+            {
+                return call(*object(storage), std::forward<Args>(args)...);
+            }
         }
-        std::swap(small, other.small);
-    }
 
-    function& operator=(function const& other)
-    {
-        auto tmp(other);
-        swap(tmp);
-        return *this;
-    }
+        static void destroy(void* storage) noexcept
+        {
+            FUNCTION_RECORD(function_storage, destroy);
+            if constexpr (stateless)
+                static_cast<void>(storage);
+            else if constexpr (small)
+                object(storage)->~CallableType();
+            else
+                delete object(storage);
+        }
+
+        // move relocates: the source is left without a target
+        static void manage(storage_operation operation, void* source, void* destination)
+        {
+            switch (operation)
+            {
+            case storage_operation::clone:
+                if constexpr (stateless)
+                {
+                }
+                else if constexpr (small)
+                {
+                    new (destination) CallableType(std::as_const(*object(source)));
+                }
+                else
+                {
+                    *static_cast<CallableType**>(destination) = new CallableType(std::as_const(*object(source)));
+                    FUNCTION_RECORD(function_storage, heap_spill);
+                }
+                FUNCTION_RECORD(function_storage, copy);
+                break;
+            case storage_operation::move:
+                if constexpr (stateless)
+                {
+                    FUNCTION_RECORD(function_storage, move);
+                    destroy(source);
+                }
+                else if constexpr (small)
+                {
+                    FUNCTION_RECORD(function_storage, move);
+                    new (destination) CallableType(std::move(*object(source)));
+                    destroy(source);
+                }
+                else
+                {
+                    *static_cast<CallableType**>(destination) = object(source);
+                }
+                break;
+            case storage_operation::destroy:
+                destroy(source);
+                break;
+#ifdef FUNCTION_INSTRUMENTATION
+            case storage_operation::swapped:
+                FUNCTION_RECORD(function_storage, swap);
+                break;
+#endif
+            }
+        }
+
+#ifdef FUNCTION_INSTRUMENTATION
+        static function_type_stats describe()
+        {
+            static char const* const qualifiers[] = {"", " const", " &", " const&", " &&", " const&&"};
+
+            function_type_stats result;
+            result.callable = type_name<CallableType>();
+            result.signature = type_name<ReturnType(Args...)>() + qualifiers[static_cast<size_t>(Qualifier)] +
+                               (Noexcept ? " noexcept" : "");
+            result.size = sizeof(CallableType);
+            result.alignment = alignof(CallableType);
+            result.small = small;
+            result.nothrow_movable = std::is_nothrow_move_constructible<CallableType>::value;
+            return result;
+        }
+#endif
+    };
 
-    function& operator=(function&& other) noexcept
+    template <typename CallableType, typename ReturnType, bool Noexcept, call_qualifier Qualifier, typename... Args>
+    struct is_compatible_callable
     {
-        auto tmp(std::move(other));
-        swap(tmp);
-        return *this;
-    }
+        typedef typename qualified_callable<CallableType, Qualifier>::type qualified_type;
+
+        static constexpr bool value = Noexcept
+                ? std::is_nothrow_invocable_r<ReturnType, qualified_type, Args...>::value
+                : std::is_invocable_r<ReturnType, qualified_type, Args...>::value;
+    };
 
-    ReturnType operator()(Args&&... args) const
+    // (object, member pointer) pair bound at run time, fits the small buffer
+    template <typename ObjectType, typename MemberPointer>
+    struct bound_member
     {
-        if (small)
-            return (reinterpret_cast<function_storage_base*>(&smallStorage))->invoke(std::forward<Args>(args)...);
-        else if (bigStorage)
-             return bigStorage->invoke(std::forward<Args>(args)...);
-        else
-            throw std::bad_function_call();
-    }
+        ObjectType* object;
+        MemberPointer member;
+
+        template <typename... CallArgs>
+        std::invoke_result_t<MemberPointer const&, ObjectType*, CallArgs...> operator()(CallArgs&&... args) const
+                noexcept(std::is_nothrow_invocable<MemberPointer const&, ObjectType*, CallArgs...>::value)
+        {
+            return details::invoke(member, object, std::forward<CallArgs>(args)...);
+        }
+    };
 
-    explicit operator bool() const noexcept
+    // member pointer fixed at compile time, the only state is the object pointer
+    template <auto Member, typename ObjectType>
+    struct member_delegate
     {
-        return small || bigStorage;
-    }
+        ObjectType* object;
 
-private:
-    class function_storage_base
+        template <typename... CallArgs>
+        std::invoke_result_t<decltype(Member), ObjectType*, CallArgs...> operator()(CallArgs&&... args) const
+                noexcept(std::is_nothrow_invocable<decltype(Member), ObjectType*, CallArgs...>::value)
+        {
+            return details::invoke(Member, object, std::forward<CallArgs>(args)...);
+        }
+    };
+
+    // Target and bound arguments laid out flat in one tuple, so an empty target takes no space
+    // and the whole closure is usually small enough for function's inline buffer.
+    template <typename CallableType, typename... BoundArgs>
+    class front_binder
     {
+        typedef std::make_index_sequence<sizeof...(BoundArgs)> bound_indices;
+
+        std::tuple<CallableType, BoundArgs...> state;
+
+        template <typename Self, size_t... Indices, typename... CallArgs>
+        static decltype(auto) apply(Self&& self, std::index_sequence<Indices...>, CallArgs&&... args)
+        {
+            return details::invoke(std::get<0>(std::forward<Self>(self).state),
+                               std::get<Indices + 1>(std::forward<Self>(self).state)...,
+                               std::forward<CallArgs>(args)...);
+        }
+
     public:
-        function_storage_base() noexcept {}
-        virtual ~function_storage_base() noexcept {}
-        virtual ReturnType invoke(Args&&... args) = 0;
-        virtual std::unique_ptr<function_storage_base> clone() const = 0;
-        virtual void cloneTo(void* destination) const = 0;
-        virtual void moveTo(void* destination) noexcept = 0;
-
-        function_storage_base(function_storage_base const&) = delete;
-        void operator= (function_storage_base const&) = delete;
+        template <typename Callable, typename... Bound>
+        explicit front_binder(Callable&& f, Bound&&... bound)
+            : state(std::forward<Callable>(f), std::forward<Bound>(bound)...)
+        {}
+
+        template <typename... CallArgs>
+        std::invoke_result_t<CallableType&, BoundArgs&..., CallArgs...> operator()(CallArgs&&... args) &
+                noexcept(std::is_nothrow_invocable<CallableType&, BoundArgs&..., CallArgs...>::value)
+        {
+            return apply(*this, bound_indices(), std::forward<CallArgs>(args)...);
+        }
+
+        template <typename... CallArgs>
+        std::invoke_result_t<CallableType const&, BoundArgs const&..., CallArgs...> operator()(CallArgs&&... args) const&
+                noexcept(std::is_nothrow_invocable<CallableType const&, BoundArgs const&..., CallArgs...>::value)
+        {
+            return apply(*this, bound_indices(), std::forward<CallArgs>(args)...);
+        }
+
+        template <typename... CallArgs>
+        std::invoke_result_t<CallableType, BoundArgs..., CallArgs...> operator()(CallArgs&&... args) &&
+                noexcept(std::is_nothrow_invocable<CallableType, BoundArgs..., CallArgs...>::value)
+        {
+            return apply(std::move(*this), bound_indices(), std::forward<CallArgs>(args)...);
+        }
+
+        template <typename... CallArgs>
+        std::invoke_result_t<CallableType const, BoundArgs const..., CallArgs...> operator()(CallArgs&&... args) const&&
+                noexcept(std::is_nothrow_invocable<CallableType const, BoundArgs const..., CallArgs...>::value)
+        {
+            return apply(std::move(*this), bound_indices(), std::forward<CallArgs>(args)...);
+        }
     };
 
-    template <typename CallableType>
-    class function_storage : public function_storage_base
+    // Everything except the call operator, which each qualified signature below declares itself.
+    // An empty function points at an invoker that throws, so calls never test for emptiness.
+    template <typename ReturnType, bool Noexcept, call_qualifier Qualifier, typename... Args>
+    class function_base
     {
-        CallableType func;
+        typedef std::aligned_storage<SMALL_SIZE, SMALL_ALIGN>::type SmallObjectType;
+        typedef ReturnType (*invoker_type)(void* storage, Args&&... args) noexcept(Noexcept);
+        typedef ReturnType (*pointer_type)(Args...) noexcept(Noexcept);
+
+        template <typename CallableType>
+        using storage = function_storage<CallableType, ReturnType, Noexcept, Qualifier, Args...>;
+
+        // Function pointers, and captureless lambdas converted to one, are kept as the pointer member so
+        // that constant evaluation, where the invoker can't reinterpret the buffer, can still call them;
+        // other targets are placed in raw, and none is active when there is nothing stored.
+        union storage_buffer
+        {
+            char none = 0;
+            mutable SmallObjectType raw;
+            pointer_type pointer;
+        };
 
     public:
-        function_storage() noexcept: function_storage_base() {}
-        function_storage(CallableType const& f) noexcept: function_storage_base(), func(f) {}
-        function_storage(CallableType&& f) noexcept : func(std::move(f)) {}
+        FUNCTION_CONSTEXPR20 function_base() noexcept : invoker(&emptyInvoker), manager(nullptr) {}
+        FUNCTION_CONSTEXPR20 function_base(std::nullptr_t) noexcept : function_base() {}
 
-        ReturnType invoke(Args&&... args)
+        FUNCTION_CONSTEXPR20 function_base(function_base const& other) : invoker(other.invoker), manager(other.manager)
         {
-            return func(std::forward<Args>(args)...);
+#ifdef FUNCTION_HAS_CONSTEXPR20
+            if (std::is_constant_evaluated())
+            {
+                buffer = other.buffer;
+                return;
+            }
+#endif
+            if (manager)
+                manager(storage_operation::clone, other.storagePointer(), storagePointer());
         }
 
-        std::unique_ptr<function_storage_base> clone() const
+        FUNCTION_CONSTEXPR20 function_base(function_base&& other) noexcept : invoker(other.invoker), manager(other.manager)
         {
-            return std::make_unique<function_storage>(func);
+#ifdef FUNCTION_HAS_CONSTEXPR20
+            if (std::is_constant_evaluated())
+                buffer = other.buffer;
+            else if (manager)
+#else
+            if (manager)
+#endif
+                manager(storage_operation::move, other.storagePointer(), storagePointer());
+            other.invoker = &emptyInvoker;
+            other.manager = nullptr;
         }
 
-        void cloneTo(void* destination) const
+        template <typename CallableType, typename = std::enable_if_t<
+                is_compatible_callable<CallableType, ReturnType, Noexcept, Qualifier, Args...>::value>>
+        FUNCTION_CONSTEXPR20 function_base(CallableType f)
         {
-            new (destination) function_storage<CallableType>(func);
+            // noexcept function pointers are kept as plain ones, which share the pointer invoker
+            if constexpr (std::is_pointer<CallableType>::value && std::is_convertible<CallableType, pointer_type>::value)
+                emplace<pointer_type>(f);
+            else
+                emplace<CallableType>(std::move(f));
+        }
+
+        // function<int(int)> f(sum, 2) builds the bind_front closure right in the buffer
+        template <typename CallableType, typename FirstBound, typename... BoundArgs, typename = std::enable_if_t<
+                is_compatible_callable<front_binder<CallableType, FirstBound, BoundArgs...>,
+                                       ReturnType, Noexcept, Qualifier, Args...>::value>>
+        function_base(CallableType f, FirstBound first, BoundArgs... bound)
+        {
+            emplace<front_binder<CallableType, FirstBound, BoundArgs...>>(
+                    std::move(f), std::move(first), std::move(bound)...);
+        }
+
+        template <typename ObjectType, typename MemberPointer, typename = std::enable_if_t<
+                std::is_member_pointer<MemberPointer>::value &&
+                is_compatible_callable<bound_member<ObjectType, MemberPointer>,
+                                       ReturnType, Noexcept, Qualifier, Args...>::value>>
+        function_base(ObjectType* object, MemberPointer member)
+            : function_base(bound_member<ObjectType, MemberPointer>{object, member})
+        {}
+
+        FUNCTION_CONSTEXPR20 ~function_base()
+        {
+#ifdef FUNCTION_HAS_CONSTEXPR20
+            // only captureless lambdas and function pointers exist here, neither needs destroying
+            if (std::is_constant_evaluated())
+                return;
+#endif
+            if (manager)
+                manager(storage_operation::destroy, storagePointer(), nullptr);
+        }
+
+        void swap(function_base& other) noexcept
+        {
+            SmallObjectType tmp;
+            if (other.manager)
+                other.manager(storage_operation::move, other.storagePointer(), &tmp);
+            if (manager)
+                manager(storage_operation::move, storagePointer(), other.storagePointer());
+            if (other.manager)
+                other.manager(storage_operation::move, &tmp, storagePointer());
+            std::swap(invoker, other.invoker);
+            std::swap(manager, other.manager);
+#ifdef FUNCTION_INSTRUMENTATION
+            if (manager)
+                manager(storage_operation::swapped, storagePointer(), nullptr);
+            if (other.manager)
+                other.manager(storage_operation::swapped, other.storagePointer(), nullptr);
+#endif
         }
 
-        void moveTo(void* destination) noexcept
+        function_base& operator=(function_base const& other)
         {
-            new (destination) function_storage<CallableType>(std::move(func));
+            auto tmp(other);
+            swap(tmp);
+            return *this;
         }
+
+        function_base& operator=(function_base&& other) noexcept
+        {
+            auto tmp(std::move(other));
+            swap(tmp);
+            return *this;
+        }
+
+    protected:
+        FUNCTION_CONSTEXPR20 ReturnType call(Args&&... args) const noexcept(Noexcept)
+        {
+#ifdef FUNCTION_HAS_CONSTEXPR20
+            if (std::is_constant_evaluated())
+                return buffer.pointer(std::forward<Args>(args)...);
+#endif
+            return invoker(storagePointer(), std::forward<Args>(args)...);
+        }
+
+    public:
+        FUNCTION_CONSTEXPR20 explicit operator bool() const noexcept
+        {
+            return manager != nullptr;
+        }
+
+    private:
+        static ReturnType emptyInvoker(void*, Args&&...) noexcept(Noexcept)
+        {
+            details::empty_call(Noexcept);
+        }
+
+        template <typename CallableType, typename... CtorArgs>
+        FUNCTION_CONSTEXPR20 void emplace(CtorArgs&&... args)
+        {
+            if constexpr (std::is_same<CallableType, pointer_type>::value)
+            {
+                buffer.pointer = pointer_type(std::forward<CtorArgs>(args)...);
+                FUNCTION_RECORD(storage<CallableType>, construct);
+            }
+            else
+            {
+                storage<CallableType>::create(storagePointer(), std::forward<CtorArgs>(args)...);
+                // never read at run time, but constant evaluation calls captureless lambdas through it
+                if constexpr (storage<CallableType>::stateless && std::is_convertible<CallableType, pointer_type>::value)
+                    buffer.pointer = CallableType{};
+            }
+            invoker = &storage<CallableType>::invoke;
+            manager = &storage<CallableType>::manage;
+        }
+
+        FUNCTION_CONSTEXPR20 void* storagePointer() const noexcept
+        {
+            return const_cast<storage_buffer*>(&buffer);
+        }
+
+        storage_buffer buffer;
+        invoker_type invoker;
+        storage_manager manager;
     };
+}
+
+template <typename T>
+class function;
+
+// Noexcept signatures accept only callables that can't throw, and calling an empty one terminates.
+// Qualified signatures invoke the target with the same qualifiers, an unqualified one keeps the
+// std::function behaviour of a const call operator invoking a non-const target.
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::none, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::none, Args...> base;
 
-private:
-    bool small;
-    union
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) const noexcept(Noexcept)
     {
-        mutable SmallObjectType smallStorage;
-        std::unique_ptr<function_storage_base> bigStorage;
-    };
+        return this->call(std::forward<Args>(args)...);
+    }
+};
+
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) const noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::const_, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::const_, Args...> base;
+
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) const noexcept(Noexcept)
+    {
+        return this->call(std::forward<Args>(args)...);
+    }
+};
+
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) & noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::lvalue, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::lvalue, Args...> base;
+
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) & noexcept(Noexcept)
+    {
+        return this->call(std::forward<Args>(args)...);
+    }
+};
+
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) const& noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::const_lvalue, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::const_lvalue, Args...> base;
+
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) const& noexcept(Noexcept)
+    {
+        return this->call(std::forward<Args>(args)...);
+    }
+};
+
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) && noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::rvalue, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::rvalue, Args...> base;
+
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) && noexcept(Noexcept)
+    {
+        return this->call(std::forward<Args>(args)...);
+    }
+};
+
+template <typename ReturnType, bool Noexcept, typename... Args>
+class function<ReturnType(Args...) const&& noexcept(Noexcept)>
+    : public details::function_base<ReturnType, Noexcept, details::call_qualifier::const_rvalue, Args...>
+{
+    typedef details::function_base<ReturnType, Noexcept, details::call_qualifier::const_rvalue, Args...> base;
+
+public:
+    using base::base;
+
+    FUNCTION_CONSTEXPR20 ReturnType operator()(Args... args) const&& noexcept(Noexcept)
+    {
+        return this->call(std::forward<Args>(args)...);
+    }
 };
 
+// Delegate to a member known at compile time: function<void(int)> f = bind_member<&widget::resize>(&w);
+template <auto Member, typename ObjectType>
+details::member_delegate<Member, ObjectType> bind_member(ObjectType* object) noexcept
+{
+    static_assert(std::is_member_pointer<decltype(Member)>::value, "bind_member expects a member pointer");
+    return {object};
+}
+
+// Partial application without std::bind's placeholder machinery: bind_front(sum, 2)(3) == sum(2, 3)
+template <typename CallableType, typename... BoundArgs>
+details::front_binder<std::decay_t<CallableType>, std::decay_t<BoundArgs>...>
+bind_front(CallableType&& f, BoundArgs&&... args)
+{
+    return details::front_binder<std::decay_t<CallableType>, std::decay_t<BoundArgs>...>(
+            std::forward<CallableType>(f), std::forward<BoundArgs>(args)...);
+}
+
+// Signatures that FUNCTION_EXTERN_TEMPLATES builds only once, in function.cpp, instead of in every
+// translation unit that uses them.
+#define FUNCTION_COMMON_INSTANTIATIONS(INSTANTIATE) \
+    INSTANTIATE(class details::function_base<void, false, details::call_qualifier::none>) \
+    INSTANTIATE(class function<void()>) \
+    INSTANTIATE(class details::function_base<void, true, details::call_qualifier::none>) \
+    INSTANTIATE(class function<void() noexcept>) \
+    INSTANTIATE(class details::function_base<bool, false, details::call_qualifier::none>) \
+    INSTANTIATE(class function<bool()>) \
+    INSTANTIATE(class details::function_base<int, false, details::call_qualifier::none>) \
+    INSTANTIATE(class function<int()>) \
+    INSTANTIATE(class details::function_base<void, false, details::call_qualifier::none, int>) \
+    INSTANTIATE(class function<void(int)>) \
+    INSTANTIATE(class details::function_base<int, false, details::call_qualifier::none, int>) \
+    INSTANTIATE(class function<int(int)>)
+
+#ifdef FUNCTION_EXTERN_TEMPLATES
+#define FUNCTION_EXTERN_INSTANTIATION(...) extern template __VA_ARGS__;
+FUNCTION_COMMON_INSTANTIATIONS(FUNCTION_EXTERN_INSTANTIATION)
+#undef FUNCTION_EXTERN_INSTANTIATION
+#endif
+
 #endif //FUNCTION_FUNCTION_H
@@ -0,0 +1,338 @@
+#ifndef FUNCTION_FUNCTION_INSTRUMENTATION_H
+#define FUNCTION_FUNCTION_INSTRUMENTATION_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Per-callable-type event counters, compiled in only when FUNCTION_INSTRUMENTATION is defined.
+// Every thread bumps its own counters with plain relaxed stores; they are summed on demand, and a
+// thread's totals are folded into the registry when it exits.
+
+enum class function_event
+{
+    construct,
+    heap_spill,
+    copy,
+    move,
+    swap,
+    invoke,
+    destroy
+};
+
+constexpr size_t FUNCTION_EVENT_COUNT = 7;
+
+struct function_type_stats
+{
+    std::string callable;
+    std::string signature;
+    size_t size = 0;
+    size_t alignment = 0;
+    bool small = false;
+    bool nothrow_movable = false;
+    std::array<std::uint64_t, FUNCTION_EVENT_COUNT> counts = {};
+
+    std::uint64_t count(function_event event) const noexcept
+    {
+        return counts[static_cast<size_t>(event)];
+    }
+
+    // rough relative weights: an allocation dwarfs a copy, which dwarfs a buffer relocation
+    std::uint64_t cost() const noexcept
+    {
+        return count(function_event::heap_spill) * 16 + count(function_event::copy) * 4 +
+               count(function_event::move) + count(function_event::swap);
+    }
+};
+
+namespace details
+{
+    template <typename T>
+    char const* pretty_type_name() noexcept
+    {
+        return __PRETTY_FUNCTION__;
+    }
+
+    // the type as the compiler spells it, without RTTI
+    template <typename T>
+    std::string type_name()
+    {
+        std::string pretty = pretty_type_name<T>();
+        size_t const begin = pretty.find("T = ");
+        size_t const end = pretty.rfind(']');
+        if (begin == std::string::npos || end == std::string::npos || end < begin)
+            return pretty;
+        return pretty.substr(begin + 4, end - begin - 4);
+    }
+
+    constexpr size_t INSTRUMENTATION_BLOCK_TYPES = 64;
+
+    struct instrumentation_block
+    {
+        std::atomic<std::uint64_t> counts[INSTRUMENTATION_BLOCK_TYPES][FUNCTION_EVENT_COUNT];
+    };
+
+    class instrumentation_registry;
+
+    // Counters written only by the owning thread, in blocks of INSTRUMENTATION_BLOCK_TYPES types so
+    // that registering new types never moves existing counters.
+    class instrumentation_thread
+    {
+    public:
+        instrumentation_thread();
+        ~instrumentation_thread();
+
+        void record(size_t type, function_event event) noexcept
+        {
+            size_t const block = type / INSTRUMENTATION_BLOCK_TYPES;
+            if (block >= blocks.size())
+                grow(block);
+            std::atomic<std::uint64_t>& counter =
+                    blocks[block]->counts[type % INSTRUMENTATION_BLOCK_TYPES][static_cast<size_t>(event)];
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+    private:
+        friend class instrumentation_registry;
+
+        void grow(size_t block) noexcept;
+
+        std::vector<std::unique_ptr<instrumentation_block>> blocks;
+    };
+
+    class instrumentation_registry
+    {
+    public:
+        static instrumentation_registry& instance()
+        {
+            static instrumentation_registry registry;
+            return registry;
+        }
+
+        size_t add(function_type_stats description)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            description.counts = {};
+            types.push_back(std::move(description));
+            retired.emplace_back();
+            baseline.emplace_back();
+            return types.size() - 1;
+        }
+
+        void attach(instrumentation_thread* thread)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.push_back(thread);
+        }
+
+        void detach(instrumentation_thread* thread)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            collect(*thread, retired);
+            threads.erase(std::find(threads.begin(), threads.end(), thread));
+        }
+
+        void grow(instrumentation_thread& thread, size_t block)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (thread.blocks.size() <= block)
+                thread.blocks.push_back(std::make_unique<instrumentation_block>());
+        }
+
+        std::vector<function_type_stats> snapshot()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<counts_type> totals = current();
+            std::vector<function_type_stats> result = types;
+            for (size_t type = 0; type < result.size(); ++type)
+                for (size_t event = 0; event < FUNCTION_EVENT_COUNT; ++event)
+                    result[type].counts[event] = totals[type][event] - baseline[type][event];
+            return result;
+        }
+
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            baseline = current();
+        }
+
+    private:
+        typedef std::array<std::uint64_t, FUNCTION_EVENT_COUNT> counts_type;
+
+        instrumentation_registry() = default;
+
+        std::vector<counts_type> current() const
+        {
+            std::vector<counts_type> totals = retired;
+            for (instrumentation_thread* thread : threads)
+                collect(*thread, totals);
+            return totals;
+        }
+
+        void collect(instrumentation_thread const& thread, std::vector<counts_type>& totals) const
+        {
+            for (size_t block = 0; block < thread.blocks.size(); ++block)
+            {
+                for (size_t offset = 0; offset < INSTRUMENTATION_BLOCK_TYPES; ++offset)
+                {
+                    size_t const type = block * INSTRUMENTATION_BLOCK_TYPES + offset;
+                    if (type >= totals.size())
+                        return;
+                    for (size_t event = 0; event < FUNCTION_EVENT_COUNT; ++event)
+                        totals[type][event] += thread.blocks[block]->counts[offset][event].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::mutex mutex;
+        std::vector<function_type_stats> types;
+        std::vector<instrumentation_thread*> threads;
+        std::vector<counts_type> retired;
+        std::vector<counts_type> baseline;
+    };
+
+    inline instrumentation_thread::instrumentation_thread()
+    {
+        instrumentation_registry::instance().attach(this);
+    }
+
+    inline instrumentation_thread::~instrumentation_thread()
+    {
+        instrumentation_registry::instance().detach(this);
+    }
+
+    inline void instrumentation_thread::grow(size_t block) noexcept
+    {
+        instrumentation_registry::instance().grow(*this, block);
+    }
+
+    inline instrumentation_thread& current_instrumentation_thread()
+    {
+        static thread_local instrumentation_thread thread;
+        return thread;
+    }
+
+    // StorageType::describe() names the callable and the signature it is stored for
+    template <typename StorageType>
+    void record_function_event(function_event event) noexcept
+    {
+        static size_t const type = instrumentation_registry::instance().add(StorageType::describe());
+        current_instrumentation_thread().record(type, event);
+    }
+}
+
+namespace details
+{
+    constexpr size_t round_up(size_t value, size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // function's own size with a capacity byte buffer followed by the invoker and manager pointers
+    constexpr size_t function_layout_size(size_t capacity, size_t alignment) noexcept
+    {
+        size_t const bufferAlignment = std::max(alignof(void*), alignment);
+        return round_up(round_up(std::max(capacity, sizeof(void*)), bufferAlignment) + 2 * sizeof(void*), bufferAlignment);
+    }
+
+    inline bool fits_small_buffer(function_type_stats const& stats, size_t capacity, size_t alignment) noexcept
+    {
+        return stats.nothrow_movable && stats.size <= capacity && stats.alignment <= alignment;
+    }
+}
+
+// What a different small buffer would have done to the constructions recorded so far.
+struct function_capacity_estimate
+{
+    std::string signature;
+    size_t capacity;
+    size_t function_size;
+    std::uint64_t constructions;
+    std::uint64_t spills;
+
+    double spill_rate() const noexcept
+    {
+        return constructions == 0 ? 0.0 : double(spills) / double(constructions);
+    }
+};
+
+namespace function_instrumentation
+{
+    // counters since the last reset, most expensive types first
+    inline std::vector<function_type_stats> snapshot()
+    {
+        std::vector<function_type_stats> result = details::instrumentation_registry::instance().snapshot();
+        std::stable_sort(result.begin(), result.end(), [](function_type_stats const& a, function_type_stats const& b)
+        {
+            return a.cost() > b.cost();
+        });
+        return result;
+    }
+
+    inline void reset()
+    {
+        details::instrumentation_registry::instance().reset();
+    }
+
+    // one row per signature and candidate capacity, alignment is the buffer's (SMALL_ALIGN)
+    inline std::vector<function_capacity_estimate> capacity_report(
+            std::vector<size_t> const& capacities = {16, 24, 32, 48, 64, 128}, size_t alignment = 32)
+    {
+        std::map<std::string, std::vector<function_type_stats>> bySignature;
+        for (function_type_stats& stats : details::instrumentation_registry::instance().snapshot())
+            bySignature[stats.signature].push_back(std::move(stats));
+
+        std::vector<function_capacity_estimate> result;
+        for (auto const& entry : bySignature)
+        {
+            for (size_t capacity : capacities)
+            {
+                function_capacity_estimate estimate{entry.first, capacity,
+                                                    details::function_layout_size(capacity, alignment), 0, 0};
+                for (function_type_stats const& stats : entry.second)
+                {
+                    std::uint64_t const constructions = stats.count(function_event::construct);
+                    estimate.constructions += constructions;
+                    if (!details::fits_small_buffer(stats, capacity, alignment))
+                        estimate.spills += constructions;
+                }
+                result.push_back(estimate);
+            }
+        }
+        return result;
+    }
+
+    inline void dump_capacity_report(std::ostream& out, std::vector<size_t> const& capacities = {16, 24, 32, 48, 64, 128})
+    {
+        for (function_capacity_estimate const& estimate : capacity_report(capacities))
+        {
+            out << estimate.signature << ": capacity " << estimate.capacity << ", sizeof(function) "
+                << estimate.function_size << ", " << estimate.spills << " of " << estimate.constructions
+                << " constructions spill (" << estimate.spill_rate() * 100 << "%)\n";
+        }
+    }
+
+    inline void dump(std::ostream& out)
+    {
+        static char const* const names[FUNCTION_EVENT_COUNT] =
+                {"construct", "heap_spill", "copy", "move", "swap", "invoke", "destroy"};
+
+        for (function_type_stats const& stats : snapshot())
+        {
+            out << stats.callable << " as " << stats.signature << " (size " << stats.size << ", align "
+                << stats.alignment << (stats.small ? ", small" : ", heap") << "): cost " << stats.cost();
+            for (size_t event = 0; event < FUNCTION_EVENT_COUNT; ++event)
+                out << ' ' << names[event] << '=' << stats.counts[event];
+            out << '\n';
+        }
+    }
+}
+
+#endif //FUNCTION_FUNCTION_INSTRUMENTATION_H
@@ -0,0 +1,222 @@
+#ifndef FUNCTION_FUNCTION_QUEUE_H
+#define FUNCTION_FUNCTION_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <function.h>
+
+template <typename T>
+class spsc_function_queue;
+
+// Single-producer/single-consumer queue of callables. Every callable is placed straight into the
+// ring as a variable-length record (header with the invoker followed by the callable itself), so
+// pushing never allocates and short closures take only a few bytes.
+template <typename ReturnType, bool Noexcept, typename... Args>
+class spsc_function_queue<ReturnType(Args...) noexcept(Noexcept)>
+{
+    template <typename CallableType>
+    using function_storage = details::function_storage<CallableType, ReturnType, Noexcept, details::call_qualifier::none, Args...>;
+
+    typedef ReturnType (*invoker_type)(void* object, Args&&... args) noexcept(Noexcept);
+    typedef void (*destroyer_type)(void* object) noexcept;
+
+    // records always hold the callable in place, whatever function would do with it
+    template <typename CallableType>
+    struct record_ops
+    {
+        static ReturnType invoke(void* object, Args&&... args) noexcept(Noexcept)
+        {
+            return function_storage<CallableType>::call(*static_cast<CallableType*>(object), std::forward<Args>(args)...);
+        }
+
+        static void destroy(void* object) noexcept
+        {
+            FUNCTION_RECORD(function_storage<CallableType>, destroy);
+            static_cast<CallableType*>(object)->~CallableType();
+        }
+    };
+
+    static constexpr size_t RECORD_ALIGN = alignof(std::max_align_t);
+    static constexpr size_t CACHE_LINE = 64;
+
+    typedef std::aligned_storage<RECORD_ALIGN, RECORD_ALIGN>::type BlockType;
+
+    struct record_header
+    {
+        // size == 0 marks the unused tail of the ring, the next record starts at offset 0
+        unsigned size;
+        unsigned offset;
+        invoker_type invoke;
+        destroyer_type destroy;
+    };
+
+    static constexpr size_t round_up(size_t value, size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    template <typename CallableType>
+    struct record_layout
+    {
+        static_assert(alignof(CallableType) <= RECORD_ALIGN,
+                      "over-aligned callables can't be stored in spsc_function_queue");
+
+        static constexpr size_t offset = round_up(sizeof(record_header), alignof(CallableType));
+        static constexpr size_t size = round_up(offset + sizeof(CallableType), RECORD_ALIGN);
+    };
+
+public:
+    // capacity is in bytes and is rounded up to a power of two
+    explicit spsc_function_queue(size_t capacity)
+        : capacity_(RECORD_ALIGN), buffer()
+    {
+        while (capacity_ < capacity)
+            capacity_ *= 2;
+        buffer.reset(new BlockType[capacity_ / RECORD_ALIGN]);
+    }
+
+    ~spsc_function_queue()
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        size_t const tail = tailIndex.load(std::memory_order_acquire);
+        while (head != tail)
+        {
+            record_header* header = skipPadding(head);
+            header->destroy(objectAt(head, header));
+            head += header->size;
+        }
+    }
+
+    spsc_function_queue(spsc_function_queue const&) = delete;
+    spsc_function_queue& operator=(spsc_function_queue const&) = delete;
+
+    // producer side
+    template <typename CallableType>
+    bool try_push(CallableType&& f)
+    {
+        typedef std::decay_t<CallableType> StoredType;
+        static_assert(details::is_compatible_callable<StoredType, ReturnType, Noexcept, details::call_qualifier::none, Args...>::value,
+                      "callable doesn't match the queue signature");
+        constexpr size_t size = record_layout<StoredType>::size;
+
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t const contiguous = capacity_ - (tail & (capacity_ - 1));
+        size_t const required = size <= contiguous ? size : contiguous + size;
+        if (capacity_ - (tail - cachedHead) < required)
+        {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (capacity_ - (tail - cachedHead) < required)
+                return false;
+        }
+
+        if (size > contiguous)
+        {
+            headerAt(tail)->size = 0;
+            tail += contiguous;
+        }
+        record_header* header = headerAt(tail);
+        header->size = size;
+        header->offset = record_layout<StoredType>::offset;
+        header->invoke = &record_ops<StoredType>::invoke;
+        header->destroy = &record_ops<StoredType>::destroy;
+        new (objectAt(tail, header)) StoredType(std::forward<CallableType>(f));
+        FUNCTION_RECORD(function_storage<StoredType>, construct);
+
+        tailIndex.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: invokes and destroys the oldest callable, returns false if the queue is empty
+    bool try_invoke(Args... args)
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail)
+        {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail)
+                return false;
+        }
+
+        consume(head, std::forward<Args>(args)...);
+        headIndex.store(head, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: drains everything published so far and hands the space back to the producer
+    // once, returns the number of invoked callables
+    size_t invoke_all(Args... args)
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        cachedTail = tailIndex.load(std::memory_order_acquire);
+        size_t count = 0;
+        for (; head != cachedTail; ++count)
+            consume(head, Args(args)...);
+        headIndex.store(head, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side
+    bool empty() const noexcept
+    {
+        return headIndex.load(std::memory_order_relaxed) == tailIndex.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+private:
+    unsigned char* bytes() const noexcept
+    {
+        return reinterpret_cast<unsigned char*>(buffer.get());
+    }
+
+    record_header* headerAt(size_t index) const noexcept
+    {
+        return reinterpret_cast<record_header*>(bytes() + (index & (capacity_ - 1)));
+    }
+
+    void* objectAt(size_t index, record_header const* header) const noexcept
+    {
+        return bytes() + (index & (capacity_ - 1)) + header->offset;
+    }
+
+    record_header* skipPadding(size_t& index) const noexcept
+    {
+        record_header* header = headerAt(index);
+        if (header->size == 0)
+        {
+            index += capacity_ - (index & (capacity_ - 1));
+            header = headerAt(index);
+        }
+        return header;
+    }
+
+    void consume(size_t& index, Args&&... args)
+    {
+        struct consumed_record
+        {
+            record_header* header;
+            void* object;
+            ~consumed_record() { header->destroy(object); }
+        };
+
+        record_header* header = skipPadding(index);
+        consumed_record record{header, objectAt(index, header)};
+        index += header->size;
+        header->invoke(record.object, std::forward<Args>(args)...);
+    }
+
+    size_t capacity_;
+    std::unique_ptr<BlockType[]> buffer;
+
+    alignas(CACHE_LINE) std::atomic<size_t> headIndex{0};
+    size_t cachedTail = 0;
+
+    alignas(CACHE_LINE) std::atomic<size_t> tailIndex{0};
+    size_t cachedHead = 0;
+};
+
+#endif //FUNCTION_FUNCTION_QUEUE_H
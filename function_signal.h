@@ -0,0 +1,121 @@
+#ifndef FUNCTION_FUNCTION_SIGNAL_H
+#define FUNCTION_FUNCTION_SIGNAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <function.h>
+#include <epoch.h>
+
+template <typename T>
+class function_signal;
+
+// Multicast delegate. Subscribers live in an immutable contiguous snapshot which emit() walks
+// without locks; connect() and disconnect() publish a modified copy and retire the old one.
+template <typename... Args>
+class function_signal<void(Args...)>
+{
+    typedef function<void(Args...)> function_type;
+    typedef details::epoch_reclaimer::read_guard read_guard;
+
+public:
+    typedef std::uint64_t connection;
+
+private:
+    struct subscriber
+    {
+        connection id;
+        function_type f;
+    };
+
+    typedef std::vector<subscriber> snapshot;
+
+public:
+    function_signal() noexcept : current(nullptr) {}
+
+    ~function_signal()
+    {
+        delete current.load(std::memory_order_relaxed);
+    }
+
+    function_signal(function_signal const&) = delete;
+    function_signal& operator=(function_signal const&) = delete;
+
+    connection connect(function_type f)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        snapshot const* old = current.load(std::memory_order_relaxed);
+        auto replacement = std::make_unique<snapshot>();
+        replacement->reserve((old ? old->size() : 0) + 1);
+        if (old)
+            replacement->insert(replacement->end(), old->begin(), old->end());
+        connection const id = ++lastConnection;
+        replacement->push_back({id, std::move(f)});
+        publish(replacement.release());
+        return id;
+    }
+
+    bool disconnect(connection id)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        snapshot const* old = current.load(std::memory_order_relaxed);
+        if (!old)
+            return false;
+
+        auto replacement = std::make_unique<snapshot>();
+        replacement->reserve(old->size());
+        for (subscriber const& s : *old)
+        {
+            if (s.id != id)
+                replacement->push_back(s);
+        }
+        if (replacement->size() == old->size())
+            return false;
+        publish(replacement->empty() ? nullptr : replacement.release());
+        return true;
+    }
+
+    void disconnect_all()
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        publish(nullptr);
+    }
+
+    void emit(Args... args) const
+    {
+        read_guard guard;
+        snapshot const* subscribers = current.load(std::memory_order_seq_cst);
+        if (!subscribers)
+            return;
+        for (subscriber const& s : *subscribers)
+            s.f(args...);
+    }
+
+    size_t size() const
+    {
+        read_guard guard;
+        snapshot const* subscribers = current.load(std::memory_order_seq_cst);
+        return subscribers ? subscribers->size() : 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return current.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    void publish(snapshot* replacement)
+    {
+        snapshot* old = current.exchange(replacement, std::memory_order_seq_cst);
+        if (old)
+            details::epoch_reclaimer::retire(old);
+    }
+
+    std::atomic<snapshot*> current;
+    std::mutex writeMutex;
+    connection lastConnection = 0;
+};
+
+#endif //FUNCTION_FUNCTION_SIGNAL_H
@@ -0,0 +1,155 @@
+#ifndef FUNCTION_FUNCTION_SLOT_MAP_H
+#define FUNCTION_FUNCTION_SLOT_MAP_H
+
+#include <cstdint>
+#include <vector>
+#include <function.h>
+
+template <typename T>
+class function_slot_map;
+
+// Functions addressed by generational handles. The functions themselves are kept densely packed for
+// iteration; erase moves the last one into the hole, and freed slots and vector capacity are reused
+// by later inserts.
+template <typename ReturnType, typename... Args>
+class function_slot_map<ReturnType(Args...)>
+{
+public:
+    typedef function<ReturnType(Args...)> function_type;
+    typedef typename std::vector<function_type>::iterator iterator;
+    typedef typename std::vector<function_type>::const_iterator const_iterator;
+
+    struct handle
+    {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;
+
+        bool operator==(handle const& other) const noexcept
+        {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(handle const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+private:
+    static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+    struct slot
+    {
+        // position in values while the slot is live, next free slot otherwise
+        std::uint32_t position;
+        std::uint32_t generation;
+    };
+
+public:
+    handle insert(function_type f)
+    {
+        if (values.size() == values.capacity())
+            reserve(values.empty() ? 8 : 2 * values.capacity());
+
+        std::uint32_t index;
+        if (freeHead != NO_SLOT)
+        {
+            index = freeHead;
+            freeHead = slots[index].position;
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({NO_SLOT, 1});
+        }
+        slots[index].position = static_cast<std::uint32_t>(values.size());
+        values.push_back(std::move(f));
+        owners.push_back(index);
+        return {index, slots[index].generation};
+    }
+
+    bool erase(handle h)
+    {
+        if (!contains(h))
+            return false;
+
+        std::uint32_t const position = slots[h.index].position;
+        std::uint32_t const last = static_cast<std::uint32_t>(values.size() - 1);
+        if (position != last)
+        {
+            values[position] = std::move(values[last]);
+            owners[position] = owners[last];
+            slots[owners[position]].position = position;
+        }
+        values.pop_back();
+        owners.pop_back();
+        release(h.index);
+        return true;
+    }
+
+    bool contains(handle h) const noexcept
+    {
+        if (h.index >= slots.size() || slots[h.index].generation != h.generation)
+            return false;
+        std::uint32_t const position = slots[h.index].position;
+        return position < owners.size() && owners[position] == h.index;
+    }
+
+    function_type* find(handle h) noexcept
+    {
+        return contains(h) ? &values[slots[h.index].position] : nullptr;
+    }
+
+    function_type const* find(handle h) const noexcept
+    {
+        return contains(h) ? &values[slots[h.index].position] : nullptr;
+    }
+
+    void clear() noexcept
+    {
+        for (std::uint32_t index : owners)
+            release(index);
+        values.clear();
+        owners.clear();
+    }
+
+    // capacity growth happens here only, so insert can't fail half way through
+    void reserve(size_t capacity)
+    {
+        values.reserve(capacity);
+        owners.reserve(capacity);
+        slots.reserve(capacity);
+    }
+
+    size_t size() const noexcept
+    {
+        return values.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return values.empty();
+    }
+
+    iterator begin() noexcept { return values.begin(); }
+    iterator end() noexcept { return values.end(); }
+    const_iterator begin() const noexcept { return values.begin(); }
+    const_iterator end() const noexcept { return values.end(); }
+
+private:
+    void release(std::uint32_t index) noexcept
+    {
+        slot& freed = slots[index];
+        if (++freed.generation == 0)
+            freed.generation = 1;
+        freed.position = freeHead;
+        freeHead = index;
+    }
+
+    std::vector<function_type> values;
+    std::vector<std::uint32_t> owners;
+    std::vector<slot> slots;
+    std::uint32_t freeHead = NO_SLOT;
+};
+
+#endif //FUNCTION_FUNCTION_SLOT_MAP_H
@@ -0,0 +1,251 @@
+#ifndef FUNCTION_INSTRUMENTED_FUNCTION_H
+#define FUNCTION_INSTRUMENTED_FUNCTION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <function.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace details
+{
+    // tsc ticks where available, steady_clock nanoseconds elsewhere
+    inline std::uint64_t latency_clock_now() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // measured once, assumes an invariant tsc
+    inline double latency_clock_nanoseconds_per_tick()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        static double const factor = []()
+        {
+            auto const start = std::chrono::steady_clock::now();
+            std::uint64_t const first = latency_clock_now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::uint64_t const last = latency_clock_now();
+            auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            return last > first ? double(elapsed) / double(last - first) : 1.0;
+        }();
+        return factor;
+#else
+        return 1.0;
+#endif
+    }
+}
+
+// Log-linear histogram of clock ticks: values below 16 are exact, larger ones land in one of 16
+// linear sub-buckets per power of two, so every bucket is within 1/16 of the values it holds.
+// Recording is a relaxed increment and safe from any number of threads.
+class latency_histogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    latency_histogram() noexcept
+    {
+        for (std::atomic<std::uint64_t>& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    latency_histogram(latency_histogram const&) = delete;
+    latency_histogram& operator=(latency_histogram const&) = delete;
+
+    void record(std::uint64_t ticks) noexcept
+    {
+        buckets[bucket_index(ticks)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (ticks > seen && !maximum.compare_exchange_weak(seen, ticks, std::memory_order_relaxed))
+        {}
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (std::atomic<std::uint64_t> const& bucket : buckets)
+            total += bucket.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    std::uint64_t max() const noexcept
+    {
+        return maximum.load(std::memory_order_relaxed);
+    }
+
+    // the highest value equivalent to the given percentile (0..100], 0 for an empty histogram
+    std::uint64_t percentile(double percent) const noexcept
+    {
+        std::uint64_t const total = count();
+        if (total == 0)
+            return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(percent / 100.0 * double(total) + 0.5);
+        rank = rank == 0 ? 1 : (rank > total ? total : rank);
+
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(bucket_upper(i), max());
+        }
+        return max();
+    }
+
+    void reset() noexcept
+    {
+        for (std::atomic<std::uint64_t>& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucket_index(std::uint64_t value) noexcept
+    {
+        if (value < SUB_BUCKETS)
+            return value;
+        unsigned const magnitude = 63 - __builtin_clzll(value);
+        unsigned const shift = magnitude - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static std::uint64_t bucket_upper(size_t index) noexcept
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+        unsigned const shift = index / SUB_BUCKETS - 1;
+        std::uint64_t const lower = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((std::uint64_t(1) << shift) - 1);
+    }
+
+private:
+    std::atomic<std::uint64_t> buckets[BUCKETS];
+    std::atomic<std::uint64_t> maximum{0};
+};
+
+struct latency_report
+{
+    std::string tag;
+    std::uint64_t count;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double max;
+};
+
+// Histograms shared by tag, so every call site instrumented under one name feeds one distribution.
+class latency_registry
+{
+public:
+    static std::shared_ptr<latency_histogram> histogram(std::string const& tag)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<latency_histogram>& entry = histograms[tag];
+        if (!entry)
+            entry = std::make_shared<latency_histogram>();
+        return entry;
+    }
+
+    // percentiles in nanoseconds, by tag
+    static std::vector<latency_report> report()
+    {
+        double const scale = details::latency_clock_nanoseconds_per_tick();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<latency_report> result;
+        for (auto const& entry : histograms)
+        {
+            latency_histogram const& h = *entry.second;
+            result.push_back({entry.first, h.count(), h.percentile(50) * scale, h.percentile(90) * scale,
+                              h.percentile(99) * scale, h.percentile(99.9) * scale, h.max() * scale});
+        }
+        return result;
+    }
+
+    static void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto const& entry : histograms)
+            entry.second->reset();
+    }
+
+private:
+    inline static std::mutex mutex;
+    inline static std::map<std::string, std::shared_ptr<latency_histogram>> histograms;
+};
+
+template <typename T>
+class instrumented_function;
+
+// A function that times a random one in every samplePeriod calls and records it under a tag.
+// Unsampled calls cost a few thread-local shifts on top of the plain call.
+template <typename ReturnType, bool Noexcept, typename... Args>
+class instrumented_function<ReturnType(Args...) noexcept(Noexcept)>
+{
+    typedef function<ReturnType(Args...) noexcept(Noexcept)> function_type;
+
+    struct timed_call
+    {
+        latency_histogram& histogram;
+        std::uint64_t start;
+        ~timed_call() { histogram.record(details::latency_clock_now() - start); }
+    };
+
+public:
+    // samplePeriod is rounded up to a power of two
+    instrumented_function(function_type f, std::string const& tag, unsigned samplePeriod = 64)
+        : target(std::move(f)), histogram_(latency_registry::histogram(tag)), sampleMask(1)
+    {
+        while (sampleMask < samplePeriod)
+            sampleMask *= 2;
+        --sampleMask;
+    }
+
+    ReturnType operator()(Args... args) const noexcept(Noexcept)
+    {
+        // xorshift rather than a call counter, which would alias with call sites that take turns
+        static thread_local std::uint32_t random = 2463534242u;
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        if ((random & sampleMask) != 0)
+            return target(std::forward<Args>(args)...);
+
+        timed_call timer{*histogram_, details::latency_clock_now()};
+        return target(std::forward<Args>(args)...);
+    }
+
+    latency_histogram const& histogram() const noexcept
+    {
+        return *histogram_;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(target);
+    }
+
+private:
+    function_type target;
+    std::shared_ptr<latency_histogram> histogram_;
+    std::uint32_t sampleMask;
+};
+
+#endif //FUNCTION_INSTRUMENTED_FUNCTION_H
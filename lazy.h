@@ -0,0 +1,73 @@
+#ifndef FUNCTION_LAZY_H
+#define FUNCTION_LAZY_H
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <function.h>
+
+// A value computed on first access, exactly once even under concurrent access. The initializer is
+// destroyed right after it has run, so its captured state doesn't outlive the computation; if it
+// throws, the next access runs it again.
+template <typename T>
+class lazy
+{
+public:
+    explicit lazy(function<T()> initializer) : initializer(std::move(initializer)) {}
+
+    ~lazy()
+    {
+        if (ready.load(std::memory_order_relaxed))
+            object()->~T();
+    }
+
+    lazy(lazy const&) = delete;
+    lazy& operator=(lazy const&) = delete;
+
+    T& get()
+    {
+        if (!ready.load(std::memory_order_acquire))
+            initialize();
+        return *object();
+    }
+
+    T const& get() const
+    {
+        if (!ready.load(std::memory_order_acquire))
+            initialize();
+        return *object();
+    }
+
+    T& operator*() { return get(); }
+    T const& operator*() const { return get(); }
+    T* operator->() { return &get(); }
+    T const* operator->() const { return &get(); }
+
+    bool has_value() const noexcept
+    {
+        return ready.load(std::memory_order_acquire);
+    }
+
+private:
+    T* object() const noexcept
+    {
+        return reinterpret_cast<T*>(&storage);
+    }
+
+    void initialize() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ready.load(std::memory_order_relaxed))
+            return;
+        new (&storage) T(initializer());
+        initializer = nullptr;
+        ready.store(true, std::memory_order_release);
+    }
+
+    mutable function<T()> initializer;
+    mutable std::mutex mutex;
+    mutable std::atomic<bool> ready{false};
+    mutable typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+};
+
+#endif //FUNCTION_LAZY_H
@@ -0,0 +1,193 @@
+#ifndef FUNCTION_MEMOIZED_FUNCTION_H
+#define FUNCTION_MEMOIZED_FUNCTION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <function.h>
+
+namespace details
+{
+    template <typename... Keys>
+    struct tuple_hash
+    {
+        size_t operator()(std::tuple<Keys...> const& key) const
+        {
+            return std::apply([](Keys const&... parts)
+            {
+                size_t seed = 0;
+                ((seed ^= std::hash<Keys>()(parts) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)), ...);
+                return seed;
+            }, key);
+        }
+    };
+}
+
+template <typename T>
+class memoized_function;
+
+// A function whose results are cached by argument values. The cache is split into independently
+// locked shards, each bounded and evicting with the CLOCK policy. Copies share one cache, so a
+// memoized_function can be stored wherever a function is expected.
+template <typename ReturnType, typename... Args>
+class memoized_function<ReturnType(Args...)>
+{
+    static_assert(!std::is_void<ReturnType>::value, "there is nothing to memoize for void results");
+
+    typedef std::tuple<std::decay_t<Args>...> key_type;
+    typedef std::decay_t<ReturnType> value_type;
+    typedef details::tuple_hash<std::decay_t<Args>...> key_hash;
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct entry
+    {
+        key_type key;
+        value_type value;
+        bool referenced;
+    };
+
+    struct alignas(CACHE_LINE) shard
+    {
+        std::mutex mutex;
+        std::unordered_map<key_type, size_t, key_hash> index;
+        std::vector<entry> entries;
+        size_t hand = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    struct state
+    {
+        function<ReturnType(Args...)> f;
+        std::unique_ptr<shard[]> shards;
+        size_t shardMask;
+        size_t shardCapacity;
+    };
+
+public:
+    struct statistics
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        size_t size = 0;
+
+        double hit_rate() const noexcept
+        {
+            return hits + misses == 0 ? 0.0 : double(hits) / double(hits + misses);
+        }
+    };
+
+    // capacity is the total number of cached results, shards is rounded up to a power of two
+    explicit memoized_function(function<ReturnType(Args...)> f, size_t capacity = 1024, size_t shards = 16)
+        : impl(std::make_shared<state>())
+    {
+        size_t count = 1;
+        while (count < shards)
+            count *= 2;
+        impl->f = std::move(f);
+        impl->shards.reset(new shard[count]);
+        impl->shardMask = count - 1;
+        impl->shardCapacity = std::max<size_t>(1, (capacity + count - 1) / count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            impl->shards[i].entries.reserve(impl->shardCapacity);
+            impl->shards[i].index.reserve(impl->shardCapacity);
+        }
+    }
+
+    ReturnType operator()(Args... args) const
+    {
+        key_type key(args...);
+        shard& s = shardFor(key);
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.index.find(key);
+            if (it != s.index.end())
+            {
+                ++s.hits;
+                entry& cached = s.entries[it->second];
+                cached.referenced = true;
+                return cached.value;
+            }
+            ++s.misses;
+        }
+
+        value_type value = impl->f(std::forward<Args>(args)...);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.index.find(key) == s.index.end())
+            insert(s, std::move(key), value);
+        return value;
+    }
+
+    statistics stats() const
+    {
+        statistics total;
+        for (size_t i = 0; i <= impl->shardMask; ++i)
+        {
+            shard& s = impl->shards[i];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.evictions += s.evictions;
+            total.size += s.entries.size();
+        }
+        return total;
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i <= impl->shardMask; ++i)
+        {
+            shard& s = impl->shards[i];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.index.clear();
+            s.entries.clear();
+            s.hand = 0;
+        }
+    }
+
+private:
+    shard& shardFor(key_type const& key) const
+    {
+        std::uint64_t h = key_hash()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return impl->shards[h & impl->shardMask];
+    }
+
+    void insert(shard& s, key_type key, value_type const& value) const
+    {
+        if (s.entries.size() < impl->shardCapacity)
+        {
+            s.index.emplace(key, s.entries.size());
+            s.entries.push_back({std::move(key), value, false});
+            return;
+        }
+
+        while (s.entries[s.hand].referenced)
+        {
+            s.entries[s.hand].referenced = false;
+            s.hand = (s.hand + 1) % s.entries.size();
+        }
+        entry& victim = s.entries[s.hand];
+        s.index.erase(victim.key);
+        s.index.emplace(key, s.hand);
+        victim.key = std::move(key);
+        victim.value = value;
+        ++s.evictions;
+        s.hand = (s.hand + 1) % s.entries.size();
+    }
+
+    std::shared_ptr<state> impl;
+};
+
+#endif //FUNCTION_MEMOIZED_FUNCTION_H
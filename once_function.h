@@ -0,0 +1,67 @@
+#ifndef FUNCTION_ONCE_FUNCTION_H
+#define FUNCTION_ONCE_FUNCTION_H
+
+#include <function.h>
+
+template <typename T>
+class once_function;
+
+// A callable that is consumed by its call: the target is invoked as an rvalue and destroyed right
+// after, even if it throws, so captured state and heap storage are released when the callback runs
+// rather than when the wrapper goes away. Calling it again throws bad_function_call.
+template <typename ReturnType, bool Noexcept, typename... Args>
+class once_function<ReturnType(Args...) noexcept(Noexcept)>
+{
+    typedef function<ReturnType(Args...) && noexcept(Noexcept)> target_type;
+
+public:
+    once_function() noexcept = default;
+    once_function(std::nullptr_t) noexcept {}
+
+    template <typename CallableType, typename = std::enable_if_t<
+            !std::is_same<std::decay_t<CallableType>, once_function>::value &&
+            std::is_constructible<target_type, CallableType>::value>>
+    once_function(CallableType&& f) : target(std::forward<CallableType>(f)) {}
+
+    once_function(once_function&& other) noexcept : target(std::move(other.target))
+    {
+        other.target = nullptr;
+    }
+
+    once_function& operator=(once_function&& other) noexcept
+    {
+        once_function tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    once_function(once_function const&) = delete;
+    once_function& operator=(once_function const&) = delete;
+
+    void swap(once_function& other) noexcept
+    {
+        target.swap(other.target);
+    }
+
+    ReturnType operator()(Args... args) noexcept(Noexcept)
+    {
+        struct consumed_target
+        {
+            target_type& target;
+            ~consumed_target() { target = nullptr; }
+        };
+
+        consumed_target guard{target};
+        return std::move(target)(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(target);
+    }
+
+private:
+    target_type target;
+};
+
+#endif //FUNCTION_ONCE_FUNCTION_H
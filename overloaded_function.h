@@ -0,0 +1,229 @@
+#ifndef FUNCTION_OVERLOADED_FUNCTION_H
+#define FUNCTION_OVERLOADED_FUNCTION_H
+
+#include <tuple>
+#include <utility>
+#include <function.h>
+
+template <typename... Signatures>
+class overloaded_function;
+
+namespace details
+{
+    enum class overloaded_operation
+    {
+        clone,
+        move,
+        destroy
+    };
+
+    template <typename Signature>
+    struct overload_invoker;
+
+    template <typename ReturnType, typename... Args>
+    struct overload_invoker<ReturnType(Args...)>
+    {
+        typedef ReturnType (*type)(void* storage, Args&&... args);
+    };
+
+    // One table per stored type, shared by all signatures: the cold operations behind one manager
+    // and an invoker per signature.
+    template <typename... Signatures>
+    struct overloaded_ops
+    {
+        void (*manage)(overloaded_operation operation, void* source, void* destination);
+        std::tuple<typename overload_invoker<Signatures>::type...> invokers;
+    };
+
+    template <typename Derived, size_t Index, typename Signature>
+    class overload_call;
+
+    template <typename Derived, size_t Index, typename ReturnType, typename... Args>
+    class overload_call<Derived, Index, ReturnType(Args...)>
+    {
+    public:
+        ReturnType operator()(Args... args) const
+        {
+            Derived const& self = static_cast<Derived const&>(*this);
+            if (!self.ops)
+                details::empty_call(false);
+            return std::get<Index>(self.ops->invokers)(self.storagePointer(), std::forward<Args>(args)...);
+        }
+    };
+
+    template <typename Derived, typename Indices, typename... Signatures>
+    class overload_calls;
+
+    template <typename Derived, size_t... Indices, typename... Signatures>
+    class overload_calls<Derived, std::index_sequence<Indices...>, Signatures...>
+        : public overload_call<Derived, Indices, Signatures>...
+    {
+    public:
+        using overload_call<Derived, Indices, Signatures>::operator()...;
+    };
+
+    template <typename CallableType, typename Signature>
+    struct is_overload_callable : std::false_type
+    {};
+
+    template <typename CallableType, typename ReturnType, typename... Args>
+    struct is_overload_callable<CallableType, ReturnType(Args...)>
+        : std::is_invocable_r<ReturnType, CallableType&, Args...>
+    {};
+}
+
+// One callable stored once, in one small buffer or heap block, invocable through several signatures;
+// the call operator overloads resolve at the call site and share a single operations table.
+template <typename... Signatures>
+class overloaded_function
+    : public details::overload_calls<overloaded_function<Signatures...>,
+                                     std::index_sequence_for<Signatures...>, Signatures...>
+{
+    typedef std::aligned_storage<SMALL_SIZE, SMALL_ALIGN>::type SmallObjectType;
+    typedef details::overloaded_ops<Signatures...> ops_type;
+    typedef details::overloaded_operation operation;
+
+    template <typename, size_t, typename>
+    friend class details::overload_call;
+
+    template <typename CallableType>
+    struct model
+    {
+        static constexpr bool small = details::is_small<CallableType>::value;
+
+        static CallableType* object(void* storage) noexcept
+        {
+            if constexpr (small)
+                return static_cast<CallableType*>(storage);
+            else
+                return *static_cast<CallableType**>(storage);
+        }
+
+        static void manage(operation op, void* source, void* destination)
+        {
+            switch (op)
+            {
+            case operation::clone:
+                if constexpr (small)
+                    new (destination) CallableType(*object(source));
+                else
+                    *static_cast<CallableType**>(destination) = new CallableType(*object(source));
+                break;
+            case operation::move:
+                if constexpr (small)
+                {
+                    new (destination) CallableType(std::move(*object(source)));
+                    object(source)->~CallableType();
+                }
+                else
+                {
+                    *static_cast<CallableType**>(destination) = object(source);
+                }
+                break;
+            case operation::destroy:
+                if constexpr (small)
+                    object(source)->~CallableType();
+                else
+                    delete object(source);
+                break;
+            }
+        }
+
+        template <typename Signature>
+        struct invoker;
+
+        template <typename ReturnType, typename... Args>
+        struct invoker<ReturnType(Args...)>
+        {
+            static ReturnType invoke(void* storage, Args&&... args)
+            {
+                if constexpr (std::is_void<ReturnType>::value)
+                    details::invoke(*object(storage), std::forward<Args>(args)...);
+                else
+                    return details::invoke(*object(storage), std::forward<Args>(args)...);
+            }
+        };
+
+        static constexpr ops_type table = {&manage, {&invoker<Signatures>::invoke...}};
+    };
+
+public:
+    overloaded_function() noexcept : ops(nullptr) {}
+    overloaded_function(std::nullptr_t) noexcept : overloaded_function() {}
+
+    template <typename CallableType, typename = std::enable_if_t<
+            (details::is_overload_callable<CallableType, Signatures>::value && ...)>>
+    overloaded_function(CallableType f)
+        : ops(&model<CallableType>::table)
+    {
+        if constexpr (model<CallableType>::small)
+            new (&storage) CallableType(std::move(f));
+        else
+            *reinterpret_cast<CallableType**>(&storage) = new CallableType(std::move(f));
+    }
+
+    overloaded_function(overloaded_function const& other)
+        : ops(other.ops)
+    {
+        if (ops)
+            ops->manage(operation::clone, other.storagePointer(), &storage);
+    }
+
+    overloaded_function(overloaded_function&& other) noexcept
+        : ops(other.ops)
+    {
+        if (ops)
+        {
+            ops->manage(operation::move, other.storagePointer(), &storage);
+            other.ops = nullptr;
+        }
+    }
+
+    ~overloaded_function()
+    {
+        if (ops)
+            ops->manage(operation::destroy, &storage, nullptr);
+    }
+
+    void swap(overloaded_function& other) noexcept
+    {
+        SmallObjectType tmp;
+        if (other.ops)
+            other.ops->manage(operation::move, &other.storage, &tmp);
+        if (ops)
+            ops->manage(operation::move, &storage, &other.storage);
+        if (other.ops)
+            other.ops->manage(operation::move, &tmp, &storage);
+        std::swap(ops, other.ops);
+    }
+
+    overloaded_function& operator=(overloaded_function const& other)
+    {
+        auto tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    overloaded_function& operator=(overloaded_function&& other) noexcept
+    {
+        auto tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return ops != nullptr;
+    }
+
+private:
+    void* storagePointer() const noexcept
+    {
+        return &storage;
+    }
+
+    ops_type const* ops;
+    mutable SmallObjectType storage;
+};
+
+#endif //FUNCTION_OVERLOADED_FUNCTION_H
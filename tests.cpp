@@ -1,6 +1,29 @@
 #include <gtest/gtest.h>
 #include <function.h>
+#include <function_queue.h>
+#include <atomic_function.h>
+#include <function_signal.h>
+#include <function_slot_map.h>
+#include <timer_wheel.h>
+#include <overloaded_function.h>
+#include <compose.h>
+#include <memoized_function.h>
+#include <lazy.h>
+#include <once_function.h>
+#include <instrumented_function.h>
+#include <dispatch_table.h>
 #include <functional>
+#include <thread>
+#include <random>
+#include <sstream>
+#include <map>
+
+// Without exceptions, whatever would have been thrown aborts instead.
+#ifdef FUNCTION_NO_EXCEPTIONS
+#define ASSERT_RAISES(statement, exception) ASSERT_DEATH(statement, "")
+#else
+#define ASSERT_RAISES(statement, exception) ASSERT_THROW(statement, exception)
+#endif
 
 void void_none_args_func()
 {
@@ -18,6 +41,7 @@ int sum(int a, int b)
     return a + b;
 }
 
+#ifndef FUNCTION_NO_EXCEPTIONS
 TEST(constuctors, default_)
 {
     try
@@ -87,7 +111,7 @@ TEST(constuctors, lambda)
         FAIL();
     }
 }
-
+#endif
 
 TEST(invokation, simple)
 {
@@ -195,4 +219,1035 @@ TEST(other, main)
 
     function<void()> f = X();
     std::function<void()> g = X();
-}
\ No newline at end of file
+}
+
+TEST(spsc_function_queue, fifo_order)
+{
+    spsc_function_queue<void(std::vector<int>&)> q(256);
+    std::array<char, 40> big = {};
+    big[0] = 3;
+    ASSERT_TRUE(q.try_push([](std::vector<int>& out){out.push_back(1);}));
+    ASSERT_TRUE(q.try_push([x = 2](std::vector<int>& out){out.push_back(x);}));
+    ASSERT_TRUE(q.try_push([big](std::vector<int>& out){out.push_back(big[0]);}));
+    std::vector<int> out;
+    while (q.try_invoke(out));
+    ASSERT_EQ(out, std::vector<int>({1, 2, 3}));
+    ASSERT_TRUE(q.empty());
+}
+
+TEST(spsc_function_queue, full_and_wrap_around)
+{
+    spsc_function_queue<void(int&)> q(128);
+    int pushed = 0;
+    int invoked = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            while (!q.try_push([](int& count){++count;}))
+                ASSERT_TRUE(q.try_invoke(invoked));
+        }
+        else
+        {
+            while (!q.try_push([a = std::array<char, 20>()](int& count){count += 1 + a[0];}))
+                ASSERT_TRUE(q.try_invoke(invoked));
+        }
+        ++pushed;
+    }
+    q.invoke_all(invoked);
+    ASSERT_EQ(invoked, pushed);
+    ASSERT_FALSE(q.try_invoke(invoked));
+}
+
+TEST(spsc_function_queue, destroys_pending)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        spsc_function_queue<void()> q(128);
+        ASSERT_TRUE(q.try_push([counter](){}));
+        ASSERT_TRUE(q.try_push([counter](){}));
+        ASSERT_EQ(counter.use_count(), 3);
+        ASSERT_TRUE(q.try_invoke());
+        ASSERT_EQ(counter.use_count(), 2);
+    }
+    ASSERT_EQ(counter.use_count(), 1);
+}
+
+TEST(spsc_function_queue, two_threads)
+{
+    spsc_function_queue<void(long long&)> q(1024);
+    const int n = 100000;
+    std::thread producer([&q]()
+    {
+        for (int i = 1; i <= n; ++i)
+            while (!q.try_push([i](long long& sum){sum += i;}))
+                std::this_thread::yield();
+    });
+    long long sum = 0;
+    for (int consumed = 0; consumed < n;)
+        if (q.try_invoke(sum))
+            ++consumed;
+        else
+            std::this_thread::yield();
+    producer.join();
+    ASSERT_EQ(sum, (long long) n * (n + 1) / 2);
+}
+
+TEST(atomic_function, store_and_call)
+{
+    atomic_function<int(int, int)> f;
+    ASSERT_FALSE(static_cast<bool>(f));
+    ASSERT_RAISES(f(1, 2), bad_function_call);
+    f.store(sum);
+    ASSERT_TRUE(static_cast<bool>(f));
+    ASSERT_EQ(f(2, 2), 4);
+    f.store([](int a, int b){return a * b;});
+    ASSERT_EQ(f(3, 3), 9);
+    function<int(int, int)> g = f.load();
+    f.store(nullptr);
+    ASSERT_FALSE(static_cast<bool>(f));
+    ASSERT_EQ(g(2, 5), 10);
+}
+
+TEST(atomic_function, store_from_callback)
+{
+    atomic_function<int()> f;
+    f.store([&f]()
+    {
+        f.store([](){return 2;});
+        return 1;
+    });
+    ASSERT_EQ(f(), 1);
+    ASSERT_EQ(f(), 2);
+}
+
+TEST(atomic_function, concurrent_readers)
+{
+    auto counter = std::make_shared<int>(0);
+    atomic_function<int()> f([counter](){return 0;});
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i)
+    {
+        readers.emplace_back([&f, &stop]()
+        {
+            while (!stop.load())
+            {
+                int value = f();
+                ASSERT_TRUE(value >= 0 && value < 1000);
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (int i = 1; i < 1000; ++i)
+        f.store([counter, i](){return i;});
+    stop.store(true);
+    for (std::thread& reader : readers)
+        reader.join();
+
+    f.store(nullptr);
+    details::epoch_reclaimer::reclaim();
+    ASSERT_EQ(counter.use_count(), 1);
+}
+
+TEST(function_signal, connect_emit_disconnect)
+{
+    function_signal<void(std::string const&, int)> s;
+    std::vector<std::string> log;
+    auto first = s.connect([&log](std::string const& name, int x){log.push_back(name + std::to_string(x));});
+    auto second = s.connect([&log](std::string const& name, int x){log.push_back(name + std::to_string(x * 2));});
+    ASSERT_EQ(s.size(), 2u);
+    s.emit("a", 1);
+    ASSERT_EQ(log, std::vector<std::string>({"a1", "a2"}));
+    ASSERT_TRUE(s.disconnect(first));
+    ASSERT_FALSE(s.disconnect(first));
+    s.emit("b", 2);
+    ASSERT_EQ(log, std::vector<std::string>({"a1", "a2", "b4"}));
+    ASSERT_TRUE(s.disconnect(second));
+    ASSERT_TRUE(s.empty());
+    s.emit("c", 3);
+    ASSERT_EQ(log.size(), 3u);
+}
+
+TEST(function_signal, arguments_are_not_moved_between_subscribers)
+{
+    function_signal<void(std::string)> s;
+    std::vector<std::string> received;
+    for (int i = 0; i < 3; ++i)
+        s.connect([&received](std::string value){received.push_back(std::move(value));});
+    s.emit(std::string(100, 'x'));
+    ASSERT_EQ(received, std::vector<std::string>(3, std::string(100, 'x')));
+}
+
+TEST(function_signal, disconnect_during_emit)
+{
+    function_signal<void()> s;
+    int calls = 0;
+    function_signal<void()>::connection self = 0;
+    self = s.connect([&s, &self, &calls](){++calls; s.disconnect(self);});
+    s.connect([&calls](){++calls;});
+    s.emit();
+    s.emit();
+    ASSERT_EQ(calls, 3);
+}
+
+TEST(function_signal, concurrent_emit)
+{
+    function_signal<void(std::atomic<int>&)> s;
+    s.connect([](std::atomic<int>& count){++count;});
+    std::atomic<bool> stop{false};
+    std::atomic<int> count{0};
+    std::vector<std::thread> publishers;
+    for (int i = 0; i < 3; ++i)
+    {
+        publishers.emplace_back([&s, &stop, &count]()
+        {
+            while (!stop.load())
+            {
+                s.emit(count);
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i)
+        s.disconnect(s.connect([](std::atomic<int>&){}));
+    stop.store(true);
+    for (std::thread& publisher : publishers)
+        publisher.join();
+    ASSERT_EQ(s.size(), 1u);
+}
+
+TEST(function_slot_map, insert_find_erase)
+{
+    function_slot_map<int(int)> map;
+    auto twice = map.insert([](int x){return 2 * x;});
+    auto square = map.insert([](int x){return x * x;});
+    auto negate = map.insert([](int x){return -x;});
+    ASSERT_EQ(map.size(), 3u);
+    ASSERT_EQ((*map.find(square))(5), 25);
+
+    ASSERT_TRUE(map.erase(twice));
+    ASSERT_FALSE(map.erase(twice));
+    ASSERT_EQ(map.find(twice), nullptr);
+    ASSERT_EQ((*map.find(square))(3), 9);
+    ASSERT_EQ((*map.find(negate))(3), -3);
+
+    auto reused = map.insert([](int x){return x + 1;});
+    ASSERT_EQ(reused.index, twice.index);
+    ASSERT_NE(reused, twice);
+    ASSERT_FALSE(map.contains(twice));
+    ASSERT_EQ((*map.find(reused))(1), 2);
+    ASSERT_FALSE(map.contains(function_slot_map<int(int)>::handle()));
+}
+
+TEST(function_slot_map, dense_iteration)
+{
+    function_slot_map<void(int&)> map;
+    std::vector<function_slot_map<void(int&)>::handle> handles;
+    for (int i = 0; i < 10; ++i)
+        handles.push_back(map.insert([i](int& total){total += i;}));
+    for (int i = 0; i < 10; i += 2)
+        map.erase(handles[i]);
+
+    int total = 0;
+    for (auto& f : map)
+        f(total);
+    ASSERT_EQ(total, 1 + 3 + 5 + 7 + 9);
+
+    map.clear();
+    ASSERT_TRUE(map.empty());
+    for (auto h : handles)
+        ASSERT_FALSE(map.contains(h));
+}
+
+TEST(function_slot_map, erase_destroys_target)
+{
+    auto counter = std::make_shared<int>(0);
+    function_slot_map<void()> map;
+    auto first = map.insert([counter](){});
+    map.insert([counter](){});
+    ASSERT_EQ(counter.use_count(), 3);
+    map.erase(first);
+    ASSERT_EQ(counter.use_count(), 2);
+}
+
+TEST(timer_wheel, fires_at_expiry)
+{
+    timer_wheel wheel(10);
+    std::mt19937_64 random(42);
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> fired;
+    size_t scheduled = 0;
+    for (std::uint64_t delay : {1ull, 5ull, 255ull, 256ull, 257ull, 65535ull, 65536ull, 70000ull, 1ull << 20})
+    {
+        wheel.schedule_after(delay, [&wheel, &fired, delay](){fired.push_back({delay, wheel.now()});});
+        ++scheduled;
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        std::uint64_t delay = random() % 300000;
+        wheel.schedule_after(delay, [&wheel, &fired, delay](){fired.push_back({delay, wheel.now()});});
+        ++scheduled;
+    }
+    ASSERT_EQ(wheel.size(), scheduled);
+
+    size_t total = 0;
+    while (!wheel.empty())
+        total += wheel.advance(wheel.now() + 1 + random() % 5000);
+    ASSERT_EQ(total, scheduled);
+    ASSERT_EQ(fired.size(), scheduled);
+    for (auto const& f : fired)
+        ASSERT_EQ(f.second, 10 + f.first);
+}
+
+TEST(timer_wheel, cancel)
+{
+    timer_wheel wheel;
+    auto counter = std::make_shared<int>(0);
+    int calls = 0;
+    auto first = wheel.schedule_after(100, [counter, &calls](){++calls;});
+    auto second = wheel.schedule_after(100000, [counter, &calls](){++calls;});
+    ASSERT_TRUE(wheel.pending(first));
+    ASSERT_TRUE(wheel.cancel(second));
+    ASSERT_FALSE(wheel.cancel(second));
+    ASSERT_EQ(counter.use_count(), 2);
+    ASSERT_EQ(wheel.advance(200000), 1u);
+    ASSERT_EQ(calls, 1);
+    ASSERT_FALSE(wheel.pending(first));
+    ASSERT_FALSE(wheel.cancel(first));
+    ASSERT_EQ(counter.use_count(), 1);
+
+    auto reused = wheel.schedule_after(1, [](){});
+    ASSERT_FALSE(wheel.pending(first));
+    ASSERT_FALSE(wheel.pending(second));
+    ASSERT_TRUE(wheel.pending(reused));
+}
+
+TEST(timer_wheel, callbacks_reschedule_and_cancel)
+{
+    timer_wheel wheel;
+    std::vector<std::uint64_t> ticks;
+    timer_wheel::handle victim;
+    function<void()> periodic;
+    periodic = [&](){
+        ticks.push_back(wheel.now());
+        if (ticks.size() < 5)
+            wheel.schedule_after(300, periodic);
+    };
+    wheel.schedule_after(300, periodic);
+    wheel.schedule_after(50, [&](){wheel.cancel(victim);});
+    victim = wheel.schedule_after(50, [&](){ticks.push_back(0);});
+    wheel.schedule_after(10, [&](){wheel.schedule_at(wheel.now(), [&](){ticks.push_back(wheel.now());});});
+    wheel.advance(10000);
+    ASSERT_EQ(ticks, std::vector<std::uint64_t>({11, 300, 600, 900, 1200}));
+}
+
+TEST(noexcept_signature, call)
+{
+    function<int(int, int) noexcept> f([](int a, int b) noexcept {return a + b;});
+    ASSERT_EQ(f(2, 2), 4);
+    static_assert(noexcept(f(1, 2)));
+    function<int(int, int) noexcept> g(f);
+    ASSERT_EQ(g(3, 3), 6);
+    function<void() noexcept> h([]() noexcept {return 5;});
+    h();
+}
+
+TEST(noexcept_signature, rejects_throwing_callables)
+{
+    auto throwing = [](){return 1;};
+    auto nothrow = []() noexcept {return 1;};
+    static_assert(!std::is_constructible<function<int() noexcept>, decltype(throwing)>::value);
+    static_assert(std::is_constructible<function<int() noexcept>, decltype(nothrow)>::value);
+    static_assert(std::is_constructible<function<int()>, decltype(throwing)>::value);
+    static_assert(!noexcept(std::declval<function<int()>&>()()));
+    static_assert(!std::is_constructible<function<int()>, std::string>::value);
+}
+
+TEST(noexcept_signature, empty_call_terminates)
+{
+    function<void() noexcept> f;
+    ASSERT_FALSE(static_cast<bool>(f));
+    ASSERT_DEATH(f(), "");
+}
+
+TEST(qualified_signature, const_call)
+{
+    struct counter
+    {
+        int calls = 0;
+        int operator()() { return ++calls; }
+        int operator()() const { return -1; }
+    };
+    function<int() const> f = counter();
+    ASSERT_EQ(f(), -1);
+    function<int()> g = counter();
+    ASSERT_EQ(g(), 1);
+    ASSERT_EQ(g(), 2);
+
+    auto mutable_lambda = [n = 0]() mutable {return ++n;};
+    static_assert(!std::is_constructible<function<int() const>, decltype(mutable_lambda)>::value);
+    static_assert(std::is_constructible<function<int()>, decltype(mutable_lambda)>::value);
+}
+
+TEST(qualified_signature, rvalue_call_consumes_state)
+{
+    std::vector<int> buffer(1000, 7);
+    int const* data = buffer.data();
+    function<std::vector<int>() &&> f = [buffer = std::move(buffer)]() mutable {return std::move(buffer);};
+    std::vector<int> result = std::move(f)();
+    ASSERT_EQ(result.data(), data);
+    ASSERT_EQ(result.size(), 1000u);
+}
+
+TEST(qualified_signature, dispatches_to_matching_overload)
+{
+    struct overloaded
+    {
+        int operator()() & { return 1; }
+        int operator()() const& { return 2; }
+        int operator()() && { return 3; }
+        int operator()() const&& { return 4; }
+    };
+    function<int() &> lvalue = overloaded();
+    function<int() const&> const_lvalue = overloaded();
+    function<int() &&> rvalue = overloaded();
+    function<int() const&&> const_rvalue = overloaded();
+    function<int() const noexcept> const_noexcept = []() noexcept {return 5;};
+    ASSERT_EQ(lvalue(), 1);
+    ASSERT_EQ(const_lvalue(), 2);
+    ASSERT_EQ(std::move(rvalue)(), 3);
+    ASSERT_EQ(std::move(const_rvalue)(), 4);
+    ASSERT_EQ(const_noexcept(), 5);
+    static_assert(noexcept(const_noexcept()));
+}
+
+TEST(overloaded_function, dispatches_by_argument_types)
+{
+    struct handler
+    {
+        std::string prefix;
+        std::string operator()(int x) const { return prefix + "int " + std::to_string(x); }
+        std::string operator()(std::string const& s) const { return prefix + "string " + s; }
+        std::string operator()(double, double) const { return prefix + "pair"; }
+    };
+    overloaded_function<std::string(int), std::string(std::string const&), std::string(double, double)> f
+            = handler{"> "};
+    ASSERT_EQ(f(5), "> int 5");
+    ASSERT_EQ(f(std::string("x")), "> string x");
+    ASSERT_EQ(f(1.0, 2.0), "> pair");
+}
+
+TEST(overloaded_function, copy_move_swap)
+{
+    auto counter = std::make_shared<int>(0);
+    auto small = [counter](int x){return x + 1;};
+    std::array<char, 100> payload = {};
+    payload[0] = 10;
+    auto big = [counter, payload](int x){return x + payload[0];};
+
+    overloaded_function<int(int)> f = small;
+    overloaded_function<int(int)> g = big;
+    ASSERT_EQ(counter.use_count(), 5);
+    overloaded_function<int(int)> h(f);
+    ASSERT_EQ(h(1), 2);
+    f.swap(g);
+    ASSERT_EQ(f(1), 11);
+    ASSERT_EQ(g(1), 2);
+    g = std::move(f);
+    ASSERT_FALSE(static_cast<bool>(f));
+    ASSERT_EQ(g(1), 11);
+    ASSERT_RAISES(f(1), bad_function_call);
+    f = nullptr;
+    g = nullptr;
+    h = nullptr;
+    ASSERT_EQ(counter.use_count(), 3);
+}
+
+TEST(member_delegate, object_and_member_pointer)
+{
+    struct accumulator
+    {
+        int total = 0;
+        int add(int x) { return total += x; }
+        int get() const { return total; }
+    };
+    accumulator a;
+    function<int(int)> add(&a, &accumulator::add);
+    function<int()> get(&a, &accumulator::get);
+    ASSERT_EQ(add(2), 2);
+    ASSERT_EQ(add(3), 5);
+    ASSERT_EQ(get(), 5);
+
+    function<int(accumulator const&)> unbound(&accumulator::get);
+    ASSERT_EQ(unbound(a), 5);
+    function<int(accumulator const&)> field(&accumulator::total);
+    ASSERT_EQ(field(a), 5);
+}
+
+TEST(member_delegate, pointer_like_objects)
+{
+    struct counter
+    {
+        int value = 1;
+        int scaled(int factor) const { return value * factor; }
+    };
+    function<int(std::unique_ptr<counter> const&, int)> scaled(&counter::scaled);
+    function<int&(std::shared_ptr<counter> const&)> value(&counter::value);
+    auto shared = std::make_shared<counter>();
+    value(shared) = 4;
+    ASSERT_EQ(shared->value, 4);
+    ASSERT_EQ(scaled(std::make_unique<counter>(), 3), 3);
+
+#ifndef FUNCTION_NO_EXCEPTIONS
+    function<void()> empty;
+    try
+    {
+        empty();
+        FAIL();
+    }
+    catch (std::exception const& e)
+    {
+        ASSERT_STREQ(e.what(), "bad function call");
+    }
+#endif
+}
+
+TEST(member_delegate, compile_time_member)
+{
+    struct button
+    {
+        std::vector<int> clicks;
+        void on_click(int x) noexcept { clicks.push_back(x); }
+    };
+    button b;
+    auto delegate = bind_member<&button::on_click>(&b);
+    static_assert(sizeof(delegate) == sizeof(void*));
+    function<void(int)> f = delegate;
+    function<void(int) noexcept> g = delegate;
+    f(1);
+    g(2);
+    ASSERT_EQ(b.clicks, std::vector<int>({1, 2}));
+}
+
+TEST(bind_front, partial_application)
+{
+    ASSERT_EQ(bind_front(sum, 2)(3), 5);
+    ASSERT_EQ(bind_front(sum, 2, 3)(), 5);
+    function<int(int)> f(bind_front(sum, 2));
+    ASSERT_EQ(f(2), 4);
+    function<int()> g(bind_front(sum, 3, 3));
+    ASSERT_EQ(g(), 6);
+    function<int()> h(sum, 4, 4);
+    ASSERT_EQ(h(), 8);
+    function<int(int)> k([](int a, int b){return a - b;}, 10);
+    ASSERT_EQ(k(3), 7);
+
+    std::string s = "abc";
+    auto append = ::bind_front([](std::string& target, char c){target += c;}, std::ref(s));
+    append('d');
+    ASSERT_EQ(s, "abcd");
+}
+
+TEST(bind_front, compact_layout)
+{
+    auto stateless = bind_front([](int a, int b){return a * b;}, 6);
+    static_assert(sizeof(stateless) == sizeof(int));
+    ASSERT_EQ(stateless(7), 42);
+    static_assert(sizeof(bind_front(sum, 2, 2)) <= sizeof(std::bind(sum, 2, 2)));
+}
+
+TEST(bind_front, forwards_value_category)
+{
+    auto consume = ::bind_front([](std::unique_ptr<int> p, int x){return *p + x;}, std::make_unique<int>(40));
+    ASSERT_EQ(std::move(consume)(2), 42);
+
+    struct widget
+    {
+        int scale;
+        int resize(int x) const noexcept { return x * scale; }
+    };
+    widget w{3};
+    function<int(int) noexcept> resize = bind_front(&widget::resize, &w);
+    ASSERT_EQ(resize(5), 15);
+}
+
+TEST(compose, order)
+{
+    auto add_one = [](int x){return x + 1;};
+    auto twice = [](int x){return x * 2;};
+    ASSERT_EQ(pipe(add_one, twice)(3), 8);
+    ASSERT_EQ(compose(add_one, twice)(3), 7);
+    auto to_text = [](int x){return std::to_string(x);};
+    auto length = [](std::string const& s){return s.size();};
+    ASSERT_EQ(pipe(sum, twice, to_text)(2, 3), "10");
+    ASSERT_EQ(compose(length, to_text, sum)(50, 50), 3u);
+}
+
+TEST(compose, nested_chains_are_flattened)
+{
+    auto add_one = [](int x){return x + 1;};
+    auto twice = [](int x){return x * 2;};
+    auto square = [](int x){return x * x;};
+    auto nested = pipe(pipe(add_one, twice), pipe(square, add_one));
+    static_assert(std::is_same<decltype(nested), decltype(pipe(add_one, twice, square, add_one))>::value);
+    static_assert(std::is_same<decltype(compose(compose(add_one, twice), square)),
+                               decltype(pipe(square, twice, add_one))>::value);
+    ASSERT_EQ(nested(1), 17);
+
+    function<int(int)> f = add_one;
+    function<int(int)> g = twice;
+    auto erased = pipe(f, g, pipe(f, g));
+    static_assert(std::tuple_size<std::decay_t<decltype(erased.stages())>>::value == 4);
+    function<int(int)> chain = erased;
+    ASSERT_EQ(chain(0), 6);
+}
+
+TEST(compose, mutable_stages)
+{
+    auto counter = [n = 0](int x) mutable {return x + ++n;};
+    auto chain = pipe(counter, [](int x){return -x;});
+    ASSERT_EQ(chain(10), -11);
+    ASSERT_EQ(chain(10), -12);
+}
+
+TEST(memoized_function, caches_results)
+{
+    int calls = 0;
+    memoized_function<int(int, int)> f([&calls](int a, int b){++calls; return a + b;});
+    ASSERT_EQ(f(2, 2), 4);
+    ASSERT_EQ(f(2, 2), 4);
+    ASSERT_EQ(f(2, 3), 5);
+    ASSERT_EQ(calls, 2);
+    auto stats = f.stats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.size, 2u);
+
+    function<int(int, int)> erased = f;
+    ASSERT_EQ(erased(2, 3), 5);
+    ASSERT_EQ(calls, 2);
+    f.clear();
+    ASSERT_EQ(erased(2, 3), 5);
+    ASSERT_EQ(calls, 3);
+}
+
+TEST(memoized_function, bounded_with_clock_eviction)
+{
+    int calls = 0;
+    memoized_function<std::string(std::string const&)> f(
+            [&calls](std::string const& s){++calls; return s + s;}, 4, 1);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(f(std::to_string(i)), std::to_string(i) + std::to_string(i));
+    auto stats = f.stats();
+    ASSERT_EQ(stats.size, 4u);
+    ASSERT_EQ(stats.evictions, 96u);
+
+    f("hot");
+    for (int i = 0; i < 3; ++i)
+    {
+        f("hot");
+        f("cold" + std::to_string(i));
+    }
+    int const before = calls;
+    f("hot");
+    ASSERT_EQ(calls, before);
+}
+
+TEST(memoized_function, concurrent_access)
+{
+    std::atomic<int> calls{0};
+    memoized_function<long long(int)> f([&calls](int x){++calls; return (long long) x * x;}, 64, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&f]()
+        {
+            for (int i = 0; i < 2000; ++i)
+                ASSERT_EQ(f(i % 50), (long long) (i % 50) * (i % 50));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    auto stats = f.stats();
+    ASSERT_EQ(stats.hits + stats.misses, 8000u);
+    ASSERT_GT(stats.hit_rate(), 0.5);
+}
+
+TEST(lazy, evaluates_once_and_releases_initializer)
+{
+    auto captured = std::make_shared<int>(0);
+    int calls = 0;
+    lazy<std::string> value([captured, &calls](){++calls; return std::string("config");});
+    ASSERT_FALSE(value.has_value());
+    ASSERT_EQ(captured.use_count(), 2);
+    ASSERT_EQ(*value, "config");
+    ASSERT_EQ(value->size(), 6u);
+    ASSERT_TRUE(value.has_value());
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(captured.use_count(), 1);
+}
+
+#ifndef FUNCTION_NO_EXCEPTIONS
+TEST(lazy, retries_after_exception)
+{
+    int attempts = 0;
+    lazy<int> value([&attempts](){
+        if (++attempts == 1)
+            throw std::runtime_error("not yet");
+        return 42;
+    });
+    ASSERT_THROW(value.get(), std::runtime_error);
+    ASSERT_FALSE(value.has_value());
+    ASSERT_EQ(value.get(), 42);
+    ASSERT_EQ(attempts, 2);
+}
+#endif
+
+TEST(lazy, concurrent_first_access)
+{
+    std::atomic<int> calls{0};
+    lazy<std::vector<int>> value([&calls](){
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return std::vector<int>(100, 1);
+    });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&value](){ASSERT_EQ(value->size(), 100u);});
+    for (std::thread& thread : threads)
+        thread.join();
+    ASSERT_EQ(calls.load(), 1);
+}
+
+TEST(once_function, releases_target_on_call)
+{
+    auto buffer = std::make_shared<std::vector<char>>(4096);
+    once_function<size_t(size_t)> handler([buffer](size_t extra){return buffer->size() + extra;});
+    ASSERT_EQ(buffer.use_count(), 2);
+    ASSERT_EQ(handler(1), 4097u);
+    ASSERT_EQ(buffer.use_count(), 1);
+    ASSERT_FALSE(static_cast<bool>(handler));
+    ASSERT_RAISES(handler(1), bad_function_call);
+}
+
+#ifndef FUNCTION_NO_EXCEPTIONS
+TEST(once_function, releases_target_when_call_throws)
+{
+    auto captured = std::make_shared<int>(0);
+    once_function<void()> handler([captured](){throw std::runtime_error("failed");});
+    ASSERT_THROW(handler(), std::runtime_error);
+    ASSERT_EQ(captured.use_count(), 1);
+    ASSERT_FALSE(static_cast<bool>(handler));
+}
+#endif
+
+TEST(once_function, move_transfers_target)
+{
+    std::string text(100, 'x');
+    once_function<std::string()> first([text](){return text;});
+    once_function<std::string()> second(std::move(first));
+    ASSERT_FALSE(static_cast<bool>(first));
+    ASSERT_TRUE(static_cast<bool>(second));
+    first = std::move(second);
+    ASSERT_EQ(first(), text);
+}
+
+TEST(latency_histogram, buckets_are_log_linear)
+{
+    latency_histogram h;
+    for (std::uint64_t value = 0; value < 16; ++value)
+        ASSERT_EQ(latency_histogram::bucket_upper(latency_histogram::bucket_index(value)), value);
+    std::mt19937_64 random(7);
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::uint64_t value = random() >> (random() % 64);
+        std::uint64_t upper = latency_histogram::bucket_upper(latency_histogram::bucket_index(value));
+        ASSERT_GE(upper, value);
+        ASSERT_LE(upper - value, value / 16);
+    }
+    ASSERT_LT(latency_histogram::bucket_index(~std::uint64_t(0)), latency_histogram::BUCKETS);
+
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        h.record(value);
+    ASSERT_EQ(h.count(), 1000u);
+    ASSERT_EQ(h.max(), 1000u);
+    ASSERT_NEAR(double(h.percentile(50)), 500.0, 500.0 / 16);
+    ASSERT_NEAR(double(h.percentile(99)), 990.0, 990.0 / 16);
+    ASSERT_EQ(h.percentile(100), 1000u);
+}
+
+TEST(instrumented_function, samples_calls_by_tag)
+{
+    latency_registry::reset();
+    instrumented_function<int(int)> every([](int x){return x + 1;}, "tests.every", 1);
+    instrumented_function<int(int)> sampled([](int x){return x * 2;}, "tests.sampled", 4);
+    for (int i = 0; i < 4096; ++i)
+    {
+        ASSERT_EQ(every(i), i + 1);
+        ASSERT_EQ(sampled(i), i * 2);
+    }
+    ASSERT_EQ(every.histogram().count(), 4096u);
+    ASSERT_GT(sampled.histogram().count(), 800u);
+    ASSERT_LT(sampled.histogram().count(), 1250u);
+
+    instrumented_function<int(int)> same_tag([](int x){return x;}, "tests.every", 1);
+    same_tag(0);
+    ASSERT_EQ(every.histogram().count(), 4097u);
+
+    bool reported = false;
+    for (latency_report const& report : latency_registry::report())
+    {
+        if (report.tag != "tests.every")
+            continue;
+        reported = true;
+        ASSERT_EQ(report.count, 4097u);
+        ASSERT_LE(report.p50, report.p99);
+        ASSERT_LE(report.p99, report.max);
+    }
+    ASSERT_TRUE(reported);
+}
+
+#ifndef FUNCTION_NO_EXCEPTIONS
+TEST(instrumented_function, times_throwing_calls)
+{
+    instrumented_function<void()> failing([](){throw std::runtime_error("slow and broken");}, "tests.throwing", 1);
+    ASSERT_THROW(failing(), std::runtime_error);
+    ASSERT_EQ(failing.histogram().count(), 1u);
+}
+#endif
+
+enum class opcode
+{
+    load = 3,
+    store,
+    add,
+    jump = 9
+};
+
+TEST(dispatch_table, dense_enum_keys)
+{
+    dispatch_table<opcode, int(int)> table = {
+            {opcode::load, [](int x){return x;}},
+            {opcode::store, [](int x){return x + 1;}},
+            {opcode::add, [](int x){return x + 2;}},
+            {opcode::jump, [](int x){return x + 6;}},
+    };
+    ASSERT_TRUE(table.dense());
+    ASSERT_EQ(table.size(), 4u);
+    ASSERT_EQ(table(opcode::add, 10), 12);
+    ASSERT_EQ(table(opcode::jump, 10), 16);
+    ASSERT_FALSE(table.contains(static_cast<opcode>(7)));
+    ASSERT_EQ(table.find(static_cast<opcode>(100)), nullptr);
+    ASSERT_RAISES(table(static_cast<opcode>(-1), 0), bad_function_call);
+}
+
+TEST(dispatch_table, sparse_integer_keys)
+{
+    std::vector<std::pair<int, function<int(int)>>> entries;
+    std::mt19937 random(7);
+    std::map<int, int> expected;
+    while (expected.size() < 1000)
+    {
+        int const key = static_cast<int>(random());
+        int const offset = static_cast<int>(expected.size());
+        if (expected.emplace(key, offset).second)
+            entries.emplace_back(key, [offset](int x){return x + offset;});
+    }
+
+    dispatch_table<int, int(int)> table(entries.begin(), entries.end(), [](int){return -1;});
+    ASSERT_FALSE(table.dense());
+    for (auto const& entry : expected)
+        ASSERT_EQ(table(entry.first, 1), entry.second + 1);
+    ASSERT_EQ(table(expected.begin()->first + 1, 1), -1);
+    ASSERT_FALSE(table.contains(expected.begin()->first + 1));
+}
+
+TEST(dispatch_table, string_keys)
+{
+    std::string log;
+    dispatch_table<std::string_view, void(std::string&)> table = {
+            {"open", [](std::string& out){out += "o";}},
+            {"close", [](std::string& out){out += "c";}},
+            {"", [](std::string& out){out += "e";}},
+    };
+    std::string const close = "close";
+    table(close, log);
+    table("open", log);
+    table("", log);
+    ASSERT_EQ(log, "coe");
+    ASSERT_FALSE(table.contains("opened"));
+    ASSERT_RAISES(table("reset", log), bad_function_call);
+}
+
+TEST(dispatch_table, duplicate_keys_are_rejected)
+{
+    auto noop = [](int){};
+    ASSERT_RAISES((dispatch_table<int, void(int)>{{1, noop}, {2, noop}, {1, noop}}), std::invalid_argument);
+    ASSERT_RAISES((dispatch_table<int, void(int)>{{1, noop}, {1 << 20, noop}, {1 << 20, noop}}), std::invalid_argument);
+    ASSERT_RAISES((dispatch_table<std::string, void(int)>{{"a", noop}, {"a", noop}}), std::invalid_argument);
+}
+
+int empty_calls = 0;
+
+TEST(empty_call_handler, runs_before_the_call_is_reported)
+{
+    empty_call_handler previous = set_empty_call_handler([](){++empty_calls;});
+    function<int()> empty;
+    empty_calls = 0;
+    ASSERT_RAISES(empty(), bad_function_call);
+#ifndef FUNCTION_NO_EXCEPTIONS
+    ASSERT_EQ(empty_calls, 1);
+#endif
+
+    set_empty_call_handler([](){std::fputs("no target\n", stderr); std::abort();});
+    ASSERT_DEATH(empty(), "no target");
+    function<void() noexcept> nothrow;
+    ASSERT_DEATH(nothrow(), "no target");
+    set_empty_call_handler(previous);
+}
+
+#ifdef FUNCTION_HAS_CONSTEXPR20
+constexpr int twice(int x) noexcept
+{
+    return x * 2;
+}
+
+constexpr int negate(int x) noexcept
+{
+    return -x;
+}
+
+constexpr function<int(int) noexcept> constexpr_dispatch[] = {
+        [](int x) noexcept { return x + 1; },
+        twice,
+        negate,
+        [](int x) noexcept { return x * x; },
+};
+
+TEST(constexpr_function, compile_time_dispatch_table)
+{
+    static_assert(constexpr_dispatch[0](4) == 5);
+    static_assert(constexpr_dispatch[1](4) == 8);
+    static_assert(constexpr_dispatch[2](4) == -4);
+    static_assert(constexpr_dispatch[3](4) == 16);
+    for (auto const& f : constexpr_dispatch)
+        ASSERT_TRUE(static_cast<bool>(f));
+    ASSERT_EQ(constexpr_dispatch[1](21), 42);
+    ASSERT_EQ(constexpr_dispatch[3](-3), 9);
+}
+
+TEST(constexpr_function, empty_copy_and_move)
+{
+    static_assert(!static_cast<bool>(function<int(int)>()));
+    static_assert([]
+    {
+        function<int(int)> f = twice;
+        function<int(int)> copy = f;
+        function<int(int)> moved = std::move(f);
+        return copy(3) + moved(4) + static_cast<bool>(f);
+    }() == 14);
+    static_assert([]
+    {
+        function<int(int) const> f = [](int x) { return x - 1; };
+        auto copy = f;
+        return copy(10);
+    }() == 9);
+}
+#endif
+
+#ifdef FUNCTION_INSTRUMENTATION
+namespace
+{
+    template <typename Callable>
+    function_type_stats stats_for(Callable const&)
+    {
+        std::string const name = details::type_name<Callable>();
+        for (function_type_stats const& stats : function_instrumentation::snapshot())
+            if (stats.callable == name)
+                return stats;
+        return {};
+    }
+}
+
+TEST(instrumentation, counts_small_target_events)
+{
+    int calls = 0;
+    auto small = [&calls](int x){calls += x; return calls;};
+    {
+        function<int(int)> f = small;
+        function<int(int)> g = f;
+        function<int(int)> h;
+        f(1);
+        g(2);
+        h.swap(g);
+    }
+    function_type_stats stats = stats_for(small);
+    ASSERT_EQ(stats.signature, "int(int)");
+    ASSERT_TRUE(stats.small);
+    ASSERT_EQ(stats.count(function_event::construct), 1u);
+    ASSERT_EQ(stats.count(function_event::heap_spill), 0u);
+    ASSERT_EQ(stats.count(function_event::copy), 1u);
+    ASSERT_EQ(stats.count(function_event::invoke), 2u);
+    ASSERT_EQ(stats.count(function_event::swap), 1u);
+    ASSERT_EQ(stats.count(function_event::destroy),
+              stats.count(function_event::construct) + stats.count(function_event::copy) +
+              stats.count(function_event::move));
+}
+
+TEST(instrumentation, counts_heap_spills_across_threads)
+{
+    std::array<char, 100> payload = {};
+    auto big = [payload](){return payload.size();};
+    function<size_t() const> f = big;
+    std::thread([&f](){
+        function<size_t() const> copy = f;
+        copy();
+    }).join();
+    function_type_stats stats = stats_for(big);
+    ASSERT_EQ(stats.signature, "long unsigned int() const");
+    ASSERT_FALSE(stats.small);
+    ASSERT_EQ(stats.size, 100u);
+    ASSERT_EQ(stats.count(function_event::heap_spill), 2u);
+    ASSERT_EQ(stats.count(function_event::copy), 1u);
+    ASSERT_EQ(stats.count(function_event::invoke), 1u);
+    ASSERT_EQ(stats.count(function_event::destroy), 1u);
+
+    std::ostringstream out;
+    function_instrumentation::dump(out);
+    ASSERT_NE(out.str().find("heap_spill=2"), std::string::npos);
+
+    function_instrumentation::reset();
+    ASSERT_EQ(stats_for(big).count(function_event::heap_spill), 0u);
+}
+
+TEST(instrumentation, capacity_report_matches_layout)
+{
+    ASSERT_EQ(details::function_layout_size(SMALL_SIZE, SMALL_ALIGN), sizeof(function<void()>));
+    ASSERT_EQ(details::function_layout_size(SMALL_SIZE, SMALL_ALIGN), sizeof(function<int(std::string const&) const&&>));
+    for (function_type_stats const& stats : function_instrumentation::snapshot())
+        ASSERT_EQ(details::fits_small_buffer(stats, SMALL_SIZE, SMALL_ALIGN), stats.small) << stats.callable;
+
+    std::array<char, 40> payload = {};
+    auto medium = [payload](double x){return x + payload.size();};
+    auto tiny = [](double x){return x;};
+    for (int i = 0; i < 3; ++i)
+        function<double(double) const&>{medium};
+    function<double(double) const&>{tiny};
+
+    std::map<size_t, function_capacity_estimate> bySize;
+    for (function_capacity_estimate const& estimate : function_instrumentation::capacity_report())
+        if (estimate.signature == "double(double) const&")
+            bySize.emplace(estimate.capacity, estimate);
+    ASSERT_EQ(bySize.size(), 6u);
+    ASSERT_EQ(bySize.at(16).constructions, 4u);
+    ASSERT_EQ(bySize.at(16).spills, 3u);
+    ASSERT_EQ(bySize.at(32).spills, 3u);
+    ASSERT_EQ(bySize.at(48).spills, 0u);
+    ASSERT_DOUBLE_EQ(bySize.at(24).spill_rate(), 0.75);
+    ASSERT_EQ(bySize.at(128).function_size, 160u);
+
+    std::ostringstream out;
+    function_instrumentation::dump_capacity_report(out);
+    ASSERT_NE(out.str().find("double(double) const&: capacity 48, sizeof(function) 96, 0 of 4"), std::string::npos);
+}
+#endif
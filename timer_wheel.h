@@ -0,0 +1,256 @@
+#ifndef FUNCTION_TIMER_WHEEL_H
+#define FUNCTION_TIMER_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+#include <function.h>
+
+// Hierarchical timer wheel in the classic cascading layout: four levels of 256 slots cover 2^32 ticks,
+// later timers are parked in the last level and re-cascaded. Timers are pooled nodes holding their
+// callback inline and linked by index, so schedule and cancel are O(1) and a steady-state wheel
+// doesn't allocate.
+class timer_wheel
+{
+    static constexpr unsigned LEVEL_BITS = 8;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr std::uint32_t SLOTS = 1u << LEVEL_BITS;
+    static constexpr std::uint32_t SLOT_MASK = SLOTS - 1;
+    static constexpr std::uint64_t MAX_DELAY = (std::uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1;
+
+    // link indices: one sentinel per slot, the expiry work list, then one link per timer
+    static constexpr std::uint32_t WORK_LIST = LEVELS * SLOTS;
+    static constexpr std::uint32_t FIRST_TIMER = WORK_LIST + 1;
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    struct link
+    {
+        // prev == NONE marks a free timer, next then points to the next free one
+        std::uint32_t prev;
+        std::uint32_t next;
+    };
+
+    struct timer
+    {
+        function<void()> callback;
+        std::uint64_t expiry;
+        std::uint32_t generation;
+    };
+
+public:
+    struct handle
+    {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;
+
+        bool operator==(handle const& other) const noexcept
+        {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(handle const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+    explicit timer_wheel(std::uint64_t now = 0)
+        : links(FIRST_TIMER), nextTick(now + 1)
+    {
+        for (std::uint32_t list = 0; list < FIRST_TIMER; ++list)
+            links[list] = {list, list};
+    }
+
+    timer_wheel(timer_wheel const&) = delete;
+    timer_wheel& operator=(timer_wheel const&) = delete;
+
+    // timers due at or before now() fire on the next tick
+    handle schedule_at(std::uint64_t expiry, function<void()> callback)
+    {
+        if (freeHead == NONE)
+            grow();
+
+        std::uint32_t const index = freeHead;
+        freeHead = links[FIRST_TIMER + index].next;
+        timer& t = timers[index];
+        t.callback = std::move(callback);
+        t.expiry = expiry;
+        place(index, nextTick);
+        ++count;
+        return {index, t.generation};
+    }
+
+    handle schedule_after(std::uint64_t delay, function<void()> callback)
+    {
+        return schedule_at(now() + delay, std::move(callback));
+    }
+
+    bool cancel(handle h)
+    {
+        if (!pending(h))
+            return false;
+        unlink(FIRST_TIMER + h.index);
+        release(h.index);
+        return true;
+    }
+
+    bool pending(handle h) const noexcept
+    {
+        return h.index < timers.size() && timers[h.index].generation == h.generation &&
+               links[FIRST_TIMER + h.index].prev != NONE;
+    }
+
+    // moves the clock forward to now, firing every timer that became due; returns how many fired
+    size_t advance(std::uint64_t now)
+    {
+        size_t fired = 0;
+        if (count == 0 && nextTick <= now)
+            nextTick = now + 1;
+
+        while (nextTick <= now)
+        {
+            std::uint32_t const slot = nextTick & SLOT_MASK;
+            if (slot == 0)
+                cascade();
+            ++nextTick;
+
+            splice(slot, WORK_LIST);
+            while (links[WORK_LIST].next != WORK_LIST)
+            {
+                std::uint32_t const index = links[WORK_LIST].next - FIRST_TIMER;
+                unlink(FIRST_TIMER + index);
+                function<void()> callback = std::move(timers[index].callback);
+                release(index);
+                ++fired;
+                callback();
+            }
+        }
+        return fired;
+    }
+
+    std::uint64_t now() const noexcept
+    {
+        return nextTick - 1;
+    }
+
+    size_t size() const noexcept
+    {
+        return count;
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    void reserve(size_t capacity)
+    {
+        timers.reserve(capacity);
+        links.reserve(FIRST_TIMER + capacity);
+    }
+
+private:
+    void grow()
+    {
+        size_t const old = timers.size();
+        size_t const grown = old == 0 ? 64 : 2 * old;
+        reserve(grown);
+        for (size_t index = old; index < grown; ++index)
+        {
+            timers.push_back({function<void()>(), 0, 1});
+            links.push_back({NONE, index + 1 < grown ? std::uint32_t(index + 1) : freeHead});
+        }
+        freeHead = std::uint32_t(old);
+    }
+
+    void release(std::uint32_t index) noexcept
+    {
+        timer& t = timers[index];
+        t.callback = nullptr;
+        if (++t.generation == 0)
+            t.generation = 1;
+        links[FIRST_TIMER + index] = {NONE, freeHead};
+        freeHead = index;
+        --count;
+    }
+
+    // base is the tick that will be processed next
+    void place(std::uint32_t index, std::uint64_t base) noexcept
+    {
+        std::uint64_t expiry = timers[index].expiry;
+        std::uint32_t list;
+        if (expiry < base)
+        {
+            list = base & SLOT_MASK;
+        }
+        else
+        {
+            std::uint64_t delay = expiry - base;
+            if (delay > MAX_DELAY)
+            {
+                delay = MAX_DELAY;
+                expiry = base + MAX_DELAY;
+            }
+            unsigned level = 0;
+            while (delay >= std::uint64_t(1) << (LEVEL_BITS * (level + 1)))
+                ++level;
+            list = level * SLOTS + ((expiry >> (LEVEL_BITS * level)) & SLOT_MASK);
+        }
+        pushBack(list, FIRST_TIMER + index);
+    }
+
+    void cascade() noexcept
+    {
+        for (unsigned level = 1; level < LEVELS; ++level)
+        {
+            std::uint32_t const slot = (nextTick >> (LEVEL_BITS * level)) & SLOT_MASK;
+            std::uint32_t const list = level * SLOTS + slot;
+            splice(list, WORK_LIST);
+            while (links[WORK_LIST].next != WORK_LIST)
+            {
+                std::uint32_t const node = links[WORK_LIST].next;
+                unlink(node);
+                place(node - FIRST_TIMER, nextTick);
+            }
+            if (slot != 0)
+                break;
+        }
+    }
+
+    void pushBack(std::uint32_t list, std::uint32_t node) noexcept
+    {
+        std::uint32_t const last = links[list].prev;
+        links[node] = {last, list};
+        links[last].next = node;
+        links[list].prev = node;
+    }
+
+    void unlink(std::uint32_t node) noexcept
+    {
+        link const l = links[node];
+        links[l.prev].next = l.next;
+        links[l.next].prev = l.prev;
+    }
+
+    // appends the whole list of one sentinel to another
+    void splice(std::uint32_t from, std::uint32_t to) noexcept
+    {
+        if (links[from].next == from)
+            return;
+        std::uint32_t const first = links[from].next;
+        std::uint32_t const last = links[from].prev;
+        std::uint32_t const tail = links[to].prev;
+        links[tail].next = first;
+        links[first].prev = tail;
+        links[last].next = to;
+        links[to].prev = last;
+        links[from] = {from, from};
+    }
+
+    std::vector<timer> timers;
+    std::vector<link> links;
+    std::uint32_t freeHead = NONE;
+    size_t count = 0;
+    std::uint64_t nextTick;
+};
+
+#endif //FUNCTION_TIMER_WHEEL_H